@@ -0,0 +1,44 @@
+//
+// Created by Mateusz Mikiciuk on 02/11/2025.
+//
+
+#ifndef BASIN_QUERY_H
+#define BASIN_QUERY_H
+
+#include <stdexcept>
+#include <vector>
+
+#include "query.h"
+
+/**
+ * Root and iteration count of each point of a scattered set, in the order of the query.
+ * found_roots[i] == n_roots marks a point that converged to no root within the iteration limit.
+ */
+struct BasinClassification {
+    std::vector<int> iters;
+    std::vector<int> found_roots;
+};
+
+/**
+ * Classifies the points re[i] + i im[i] with newton_query_ispc_tasks(): whole gangs of points at a time, split over
+ * tasks for large batches. poly and n_roots as for the ISPC newton_step(): null for z^n - 1, otherwise of that degree.
+ */
+inline BasinClassification classifyPoints(const std::vector<float> &re, const std::vector<float> &im,
+                                          const int max_iters, const float *real, const float *imag,
+                                          const int n_roots, const ispc::RootIndex &index,
+                                          const ispc::Polynomial *poly = nullptr, const int check_every = 1,
+                                          const ispc::IterationMethod method = ispc::METHOD_NEWTON) {
+    if (re.size() != im.size()) {
+        throw std::invalid_argument("classifyPoints: re and im hold different numbers of points");
+    }
+    const int n_points = static_cast<int>(re.size());
+    BasinClassification result{std::vector<int>(n_points), std::vector<int>(n_points)};
+    // The kernels only read the roots, the index and the polynomial
+    ispc::newton_query_ispc_tasks(n_points, re.data(), im.data(), max_iters, result.iters.data(),
+                                  result.found_roots.data(), const_cast<float *>(real), const_cast<float *>(imag),
+                                  n_roots, const_cast<ispc::RootIndex *>(&index), const_cast<ispc::Polynomial *>(poly),
+                                  check_every, method);
+    return result;
+}
+
+#endif // BASIN_QUERY_H
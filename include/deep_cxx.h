@@ -0,0 +1,156 @@
+//
+// Created by Mateusz Mikiciuk on 27/10/2025.
+//
+
+#ifndef DEEP_CXX_H
+#define DEEP_CXX_H
+
+#include <algorithm>
+#include <complex>
+#include <memory>
+#include <type_traits>
+
+#include "deep.h"
+#include "double_double_cxx.h"
+#include "root_index.h"
+
+/**
+ * Minimal complex type over float, double or DoubleDouble.
+ * std::complex is only specified for the built-in floating point types.
+ */
+template <typename T> struct ComplexT {
+    T re, im;
+
+    friend ComplexT operator+(const ComplexT &a, const ComplexT &b) { return {a.re + b.re, a.im + b.im}; }
+    friend ComplexT operator-(const ComplexT &a, const ComplexT &b) { return {a.re - b.re, a.im - b.im}; }
+    friend ComplexT operator*(const ComplexT &a, const ComplexT &b) {
+        return {a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+    }
+    friend ComplexT operator*(const ComplexT &a, const T &s) { return {a.re * s, a.im * s}; }
+    friend ComplexT operator/(const ComplexT &a, const ComplexT &b) {
+        const T denominator = b.re * b.re + b.im * b.im;
+        return {(a.re * b.re + a.im * b.im) / denominator, (a.im * b.re - a.re * b.im) / denominator};
+    }
+};
+
+template <typename T> ComplexT<T> IntPowT(ComplexT<T> z, int n) {
+    ComplexT<T> res{T(1), T(0)};
+    for (; n > 0; n >>= 1) {
+        if (n & 1)
+            res = res * z;
+        if (n > 1)
+            z = z * z;
+    }
+    return res;
+}
+
+template <typename T> ComplexT<T> NewtonStepT(const ComplexT<T> &z, const int n) {
+    const ComplexT<T> w = IntPowT(z, n - 1);
+    ComplexT<T> num = w * z * T(n - 1);
+    num.re = num.re + T(1);
+    return num / (w * T(n));
+}
+
+template <typename T> ComplexT<T> HornerStepT(const ComplexT<T> &z, const ispc::Polynomial &poly) {
+    ComplexT<T> p{T(poly.re[poly.degree]), T(poly.im[poly.degree])};
+    ComplexT<T> dp{T(0), T(0)};
+    for (int k = poly.degree - 1; k >= 0; --k) {
+        dp = dp * z + p;
+        p = p * z + ComplexT<T>{T(poly.re[k]), T(poly.im[k])};
+    }
+    return z - p / dp;
+}
+
+/**
+ * Pixel coordinate origin + i * step in precision T.
+ */
+template <typename T> T pixelCoord(const DoubleDouble &origin, const int i, const double step) {
+    if constexpr (std::is_same_v<T, DoubleDouble>) {
+        return origin + DoubleDouble::twoProd(i, step);
+    } else {
+        return static_cast<T>(origin.hi + (origin.lo + i * step));
+    }
+}
+
+/**
+ * Same iteration as perform_newton_cxx in precision T; the convergence test runs in float
+ * since the tolerance around a root is far above float resolution.
+ */
+template <typename T>
+void perform_newton_deep(const T &re, const T &im, const int MAX_ITERS, const int IDX, std::unique_ptr<int[]> &iters,
+                         std::unique_ptr<int[]> &found_roots, const std::unique_ptr<float[]> &real,
+                         const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                         const ispc::Polynomial *poly) {
+    ComplexT<T> z{re, im};
+
+    for (int iter = 0; iter < MAX_ITERS; ++iter) {
+        z = poly == nullptr ? NewtonStepT(z, n_roots) : HornerStepT(z, *poly);
+        constexpr float tol = 0.000001;
+        const std::complex zf{static_cast<float>(z.re), static_cast<float>(z.im)};
+        const int k = rootCandidate(index, zf, real.get(), imag.get(), n_roots);
+        if (k >= 0 && std::abs(zf - std::complex{real[k], imag[k]}) < tol) {
+            iters[IDX] = iter;
+            found_roots[IDX] = k;
+            return;
+        }
+    }
+
+    iters[IDX] = 0;
+    found_roots[IDX] = n_roots;
+}
+
+/**
+ * Cheapest precision whose rounding error at `magnitude` stays about 10 bits below the pixel spacing.
+ * Mirrors precision_for() in deep.ispc.
+ */
+inline ispc::Precision precisionFor(const double spacing, const double magnitude) {
+    const double resolution = spacing / (magnitude * 1024);
+    if (resolution >= 1.1920929e-7f)
+        return ispc::PRECISION_FLOAT;
+    if (resolution >= 2.220446e-16f)
+        return ispc::PRECISION_DOUBLE;
+    return ispc::PRECISION_DD;
+}
+
+/**
+ * C++ counterpart of newton_ispc_deep: tile x tile blocks, each in the cheapest precision that
+ * resolves it unless `precision` fixes one. poly may be null for z^n - 1.
+ */
+inline void newton_deep_cxx(const DoubleDouble &x_min, const DoubleDouble &y_min, const double dx, const double dy,
+                            const int WIDTH, const int HEIGHT, const int MAX_ITERS, std::unique_ptr<int[]> &iters,
+                            std::unique_ptr<int[]> &found_roots, const std::unique_ptr<float[]> &real,
+                            const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                            const ispc::Polynomial *poly, const ispc::Precision precision, const int tile,
+                            int *tile_precision) {
+    const int tiles_x = (WIDTH + tile - 1) / tile;
+    for (int ty = 0; ty * tile < HEIGHT; ++ty) {
+        for (int tx = 0; tx * tile < WIDTH; ++tx) {
+            const int x0 = tx * tile, x1 = std::min(x0 + tile, WIDTH);
+            const int y0 = ty * tile, y1 = std::min(y0 + tile, HEIGHT);
+
+            ispc::Precision p = precision;
+            if (p == ispc::PRECISION_AUTO) {
+                const double mx = std::max(std::abs(x_min.hi + x0 * dx), std::abs(x_min.hi + x1 * dx));
+                const double my = std::max(std::abs(y_min.hi + y0 * dy), std::abs(y_min.hi + y1 * dy));
+                p = precisionFor(std::min(dx, dy), std::max(mx, my));
+            }
+            if (tile_precision != nullptr)
+                tile_precision[ty * tiles_x + tx] = p;
+
+            const auto render = [&]<typename T>() {
+                for (int j = y0; j < y1; ++j)
+                    for (int i = x0; i < x1; ++i)
+                        perform_newton_deep(pixelCoord<T>(x_min, i, dx), pixelCoord<T>(y_min, j, dy), MAX_ITERS,
+                                            j * WIDTH + i, iters, found_roots, real, imag, n_roots, index, poly);
+            };
+            if (p == ispc::PRECISION_FLOAT)
+                render.operator()<float>();
+            else if (p == ispc::PRECISION_DOUBLE)
+                render.operator()<double>();
+            else
+                render.operator()<DoubleDouble>();
+        }
+    }
+}
+
+#endif // DEEP_CXX_H
@@ -0,0 +1,113 @@
+//
+// Created by Mateusz Mikiciuk on 27/10/2025.
+//
+
+#ifndef DOUBLE_DOUBLE_CXX_H
+#define DOUBLE_DOUBLE_CXX_H
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+/**
+ * Double-double number: the unevaluated sum hi + lo, about 106 bits of mantissa.
+ * C++ counterpart of double_double.ispc; the products use std::fma for the exact error term.
+ */
+struct DoubleDouble {
+    double hi = 0.0;
+    double lo = 0.0;
+
+    DoubleDouble() = default;
+    DoubleDouble(const double h) : hi(h) {}
+    DoubleDouble(const double h, const double l) : hi(h), lo(l) {}
+
+    static DoubleDouble quickTwoSum(const double a, const double b) {
+        const double s = a + b;
+        return {s, b - (s - a)};
+    }
+
+    static DoubleDouble twoSum(const double a, const double b) {
+        const double s = a + b;
+        const double bb = s - a;
+        return {s, (a - (s - bb)) + (b - bb)};
+    }
+
+    static DoubleDouble twoProd(const double a, const double b) {
+        const double p = a * b;
+        return {p, std::fma(a, b, -p)};
+    }
+
+    friend DoubleDouble operator+(const DoubleDouble &a, const DoubleDouble &b) {
+        DoubleDouble s = twoSum(a.hi, b.hi);
+        const DoubleDouble t = twoSum(a.lo, b.lo);
+        s = quickTwoSum(s.hi, s.lo + t.hi);
+        return quickTwoSum(s.hi, s.lo + t.lo);
+    }
+
+    friend DoubleDouble operator-(const DoubleDouble &a) { return {-a.hi, -a.lo}; }
+    friend DoubleDouble operator-(const DoubleDouble &a, const DoubleDouble &b) { return a + -b; }
+
+    friend DoubleDouble operator*(const DoubleDouble &a, const DoubleDouble &b) {
+        const DoubleDouble p = twoProd(a.hi, b.hi);
+        return quickTwoSum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+    }
+
+    friend DoubleDouble operator/(const DoubleDouble &a, const DoubleDouble &b) {
+        const double q1 = a.hi / b.hi;
+        DoubleDouble r = a - b * q1;
+        const double q2 = r.hi / b.hi;
+        r = r - b * q2;
+        const double q3 = r.hi / b.hi;
+        return quickTwoSum(q1, q2) + q3;
+    }
+
+    explicit operator float() const { return static_cast<float>(hi); }
+};
+
+/**
+ * Parses a decimal number (optional sign, fraction and exponent) to full double-double precision,
+ * so deep-zoom centres can be given with more than 17 significant digits.
+ * Sets *end to the first unparsed character, like strtod.
+ */
+inline DoubleDouble parseDoubleDouble(const char *s, const char **end) {
+    const char *p = s;
+    const bool negative = *p == '-';
+    if (*p == '-' || *p == '+') {
+        ++p;
+    }
+
+    DoubleDouble value;
+    int scale = 0;
+    bool digits = false;
+    for (bool fraction = false; std::isdigit(*p) || (*p == '.' && !fraction); ++p) {
+        if (*p == '.') {
+            fraction = true;
+            continue;
+        }
+        value = value * 10.0 + static_cast<double>(*p - '0');
+        scale -= fraction;
+        digits = true;
+    }
+    if (!digits) {
+        *end = s;
+        return {};
+    }
+    if (*p == 'e' || *p == 'E') {
+        char *exp_end = nullptr;
+        scale += static_cast<int>(strtol(p + 1, &exp_end, 10));
+        if (exp_end != p + 1) {
+            p = exp_end;
+        }
+    }
+
+    for (; scale > 0; --scale) {
+        value = value * 10.0;
+    }
+    for (; scale < 0; ++scale) {
+        value = value / 10.0;
+    }
+    *end = p;
+    return negative ? -value : value;
+}
+
+#endif // DOUBLE_DOUBLE_CXX_H
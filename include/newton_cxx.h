@@ -5,57 +5,422 @@
 #ifndef NEWTON_CXX_H
 #define NEWTON_CXX_H
 
+#include <array>
 #include <complex>
+#include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
-inline std::complex<float> Func(const std::complex<float> &z, const int n) {
-    return std::pow(z, static_cast<float>(n)) - std::complex(1.0f, 0.0f);
+#include "root_index.h"
+
+/**
+ * z^n for a non-negative integer exponent by repeated squaring.
+ */
+inline std::complex<float> IntPow(std::complex<float> z, int n) {
+    std::complex res{1.0f, 0.0f};
+    for (; n > 0; n >>= 1) {
+        if (n & 1)
+            res *= z;
+        if (n > 1)
+            z *= z;
+    }
+    return res;
 }
 
-inline std::complex<float> Deriv(const std::complex<float> &z, const int n) {
-    const std::complex tmp{static_cast<float>(n), 0.f};
-    return tmp * std::pow(z, static_cast<float>(n - 1));
+/**
+ * One Newton step for z^n - 1 in closed form: ((n-1) z^n + 1) / (n z^(n-1)).
+ */
+inline std::complex<float> NewtonStep(const std::complex<float> &z, const int n) {
+    const std::complex<float> w = IntPow(z, n - 1);
+    return (static_cast<float>(n - 1) * w * z + 1.0f) / (static_cast<float>(n) * w);
 }
 
-inline void perform_newton_cxx(const float re, const float im, const int MAX_ITERS, const int IDX,
-                               std::unique_ptr<int[]> &iters, std::unique_ptr<int[]> &found_roots,
-                               const std::unique_ptr<float[]> &real, const std::unique_ptr<float[]> &imag,
-                               const int n_roots) {
-    std::complex z{re, im};
+/**
+ * IntPow with the exponent fixed at compile time: the squaring chain is fully unrolled and forms the same
+ * products as IntPow, in the same order.
+ */
+template <int N>
+inline std::complex<float> IntPowAcc(const std::complex<float> &res, const std::complex<float> &base) {
+    if constexpr (N == 0)
+        return res;
+    else if constexpr (N == 1)
+        return res * base;
+    else
+        return IntPowAcc<N / 2>((N & 1) ? res * base : res, base * base);
+}
+
+template <int N>
+inline std::complex<float> NewtonStepN(const std::complex<float> &z) {
+    const std::complex<float> w = IntPowAcc<N - 1>({1.0f, 0.0f}, z);
+    return (static_cast<float>(N - 1) * w * z + 1.0f) / (static_cast<float>(N) * w);
+}
+
+/**
+ * One Newton step for a general polynomial, with p and p' evaluated together by Horner's scheme.
+ */
+inline std::complex<float> HornerStep(const std::complex<float> &z, const ispc::Polynomial &poly) {
+    std::complex p{poly.re[poly.degree], poly.im[poly.degree]};
+    std::complex dp{0.0f, 0.0f};
+    for (int k = poly.degree - 1; k >= 0; --k) {
+        dp = dp * z + p;
+        p = p * z + std::complex{poly.re[k], poly.im[k]};
+    }
+    return z - p / dp;
+}
+
+/**
+ * Halley step for z^n - 1; with u = z^n it reduces to z ((n-1) u + (n+1)) / ((n+1) u + (n-1)).
+ */
+inline std::complex<float> HalleyStep(const std::complex<float> &z, const int n) {
+    const std::complex<float> u = IntPow(z, n);
+    return z * (static_cast<float>(n - 1) * u + static_cast<float>(n + 1)) /
+           (static_cast<float>(n + 1) * u + static_cast<float>(n - 1));
+}
+
+/**
+ * Schroder step for z^n - 1: n z / (z^n + n - 1).
+ */
+inline std::complex<float> SchroderStep(const std::complex<float> &z, const int n) {
+    return static_cast<float>(n) * z / (IntPow(z, n) + static_cast<float>(n - 1));
+}
+
+/**
+ * p, p' and p'' of a general polynomial in one Horner pass.
+ */
+inline void HornerEval2(const std::complex<float> &z, const ispc::Polynomial &poly, std::complex<float> &p,
+                        std::complex<float> &dp, std::complex<float> &d2p) {
+    p = {poly.re[poly.degree], poly.im[poly.degree]};
+    dp = {0.0f, 0.0f};
+    std::complex half_d2p{0.0f, 0.0f};
+    for (int k = poly.degree - 1; k >= 0; --k) {
+        half_d2p = half_d2p * z + dp;
+        dp = dp * z + p;
+        p = p * z + std::complex{poly.re[k], poly.im[k]};
+    }
+    d2p = 2.0f * half_d2p;
+}
+
+inline std::complex<float> HalleyHornerStep(const std::complex<float> &z, const ispc::Polynomial &poly) {
+    std::complex<float> p, dp, d2p;
+    HornerEval2(z, poly, p, dp, d2p);
+    return z - 2.0f * p * dp / (2.0f * dp * dp - p * d2p);
+}
+
+inline std::complex<float> SchroderHornerStep(const std::complex<float> &z, const ispc::Polynomial &poly) {
+    std::complex<float> p, dp, d2p;
+    HornerEval2(z, poly, p, dp, d2p);
+    return z - p * dp / (dp * dp - p * d2p);
+}
 
-    for (int iter = 0; iter < MAX_ITERS; ++iter) {
-        z -= Func(z, n_roots) / Deriv(z, n_roots);
+/**
+ * Output sink writing the wide format: one int iteration count and one int root id per pixel.
+ */
+struct WideOutput {
+    int *iters;
+    int *found_roots;
+
+    void operator()(const int idx, const int iter, const int root) const {
+        iters[idx] = iter;
+        found_roots[idx] = root;
+    }
+};
+
+/**
+ * Output sink writing the packed format: root id in the high byte and iteration count in the low byte of one
+ * 16-bit word per pixel, the same layout as the ISPC store_pixel.
+ */
+struct PackedOutput {
+    uint16_t *packed;
+
+    void operator()(const int idx, const int iter, const int root) const {
+        packed[idx] = static_cast<uint16_t>(root << 8 | iter);
+    }
+};
+
+/**
+ * Output sink writing the final image: three bytes per pixel, copied from a palette_ispc() table so the bytes match
+ * those the ISPC kernels colour, whatever rounding or contraction either compiler applies to the HSV conversion.
+ */
+struct RgbOutput {
+    uint8_t *rgb;
+    const uint8_t *palette;
+    int max_iters;
+
+    void operator()(const int idx, const int iter, const int root) const {
+        const uint8_t *c = palette + 3 * (root * max_iters + iter);
+        rgb[3 * idx + 0] = c[0];
+        rgb[3 * idx + 1] = c[1];
+        rgb[3 * idx + 2] = c[2];
+    }
+};
+
+/**
+ * Iterates z, the point reached after start_iter steps, up to MAX_ITERS and writes the pixel through `out`.
+ * Leaves the last z in `z` and returns the iteration count reached. With index.trap_r2 set, a z inside its root's
+ * trap radius stops one step early and records the iteration that step would have converged on.
+ */
+template <typename Output, typename Step>
+inline int perform_newton_from_cxx(std::complex<float> &z, const int start_iter, const int MAX_ITERS, const int IDX,
+                                   const Output &out, const std::unique_ptr<float[]> &real,
+                                   const std::unique_ptr<float[]> &imag, const int n_roots,
+                                   const ispc::RootIndex &index, const Step &step) {
+    for (int iter = start_iter; iter < MAX_ITERS; ++iter) {
+        z = step(z);
         constexpr float tol = 0.000001;
-        for (int i = 0; i < n_roots; ++i) {
-            std::complex tmp_root{real[i], imag[i]};
-            if (std::abs(z - tmp_root) < tol) {
-                iters[IDX] = iter;
-                found_roots[IDX] = i;
-                return;
-            }
+        const int k = rootCandidate(index, z, real.get(), imag.get(), n_roots);
+        if (k < 0)
+            continue;
+        const std::complex diff = z - std::complex{real[k], imag[k]};
+        if (std::abs(diff) < tol) {
+            out(IDX, iter, k);
+            return iter + 1;
+        }
+        if (index.trap_r2 != nullptr && iter + 1 < MAX_ITERS && std::norm(diff) < index.trap_r2[k]) {
+            out(IDX, iter + 1, k);
+            return iter + 1;
         }
     }
 
-    iters[IDX] = 0;
-    found_roots[IDX] = n_roots;
+    out(IDX, 0, n_roots);
+    return MAX_ITERS;
+}
+
+template <typename Output, typename Step>
+inline int perform_newton_cxx(const float re, const float im, const int MAX_ITERS, const int IDX, const Output &out,
+                              const std::unique_ptr<float[]> &real, const std::unique_ptr<float[]> &imag,
+                              const int n_roots, const ispc::RootIndex &index, const Step &step) {
+    std::complex z{re, im};
+    return perform_newton_from_cxx(z, 0, MAX_ITERS, IDX, out, real, imag, n_roots, index, step);
+}
+
+/**
+ * Calls visit with the step of method for z^n - 1 (poly == nullptr) or for poly, chosen once rather than per step.
+ */
+template <typename Visit>
+inline void withIterationStep(const int n_roots, const ispc::Polynomial *poly, const ispc::IterationMethod method,
+                              const Visit &visit) {
+    if (poly != nullptr) {
+        if (method == ispc::METHOD_HALLEY)
+            visit([poly](const std::complex<float> &z) { return HalleyHornerStep(z, *poly); });
+        else if (method == ispc::METHOD_SCHRODER)
+            visit([poly](const std::complex<float> &z) { return SchroderHornerStep(z, *poly); });
+        else
+            visit([poly](const std::complex<float> &z) { return HornerStep(z, *poly); });
+    } else if (method == ispc::METHOD_HALLEY) {
+        visit([n_roots](const std::complex<float> &z) { return HalleyStep(z, n_roots); });
+    } else if (method == ispc::METHOD_SCHRODER) {
+        visit([n_roots](const std::complex<float> &z) { return SchroderStep(z, n_roots); });
+    } else {
+        visit([n_roots](const std::complex<float> &z) { return NewtonStep(z, n_roots); });
+    }
+}
+
+template <typename Output, typename Step>
+inline void render_cxx(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
+                       const int HEIGHT, const int MAX_ITERS, const Output &out, const std::unique_ptr<float[]> &real,
+                       const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                       const Step &step) {
+    const float dx = (x_max - x_min) / static_cast<float>(WIDTH);
+    const float dy = (y_max - y_min) / static_cast<float>(HEIGHT);
+
+    for (int j = 0; j < HEIGHT; ++j) {
+        for (int i = 0; i < WIDTH; ++i) {
+            const float x = x_min + static_cast<float>(i) * dx;
+            const float y = y_min + static_cast<float>(j) * dy;
+
+            const int idx = j * WIDTH + i;
+            perform_newton_cxx(x, y, MAX_ITERS, idx, out, real, imag, n_roots, index, step);
+        }
+    }
+}
+
+/**
+ * z^n - 1 kernel with n_roots fixed at compile time.
+ */
+template <int N, typename Output>
+void newton_cxx_n(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
+                  const int HEIGHT, const int MAX_ITERS, const Output &out, const std::unique_ptr<float[]> &real,
+                  const std::unique_ptr<float[]> &imag, int, const ispc::RootIndex &index) {
+    render_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, out, real, imag, N, index,
+               [](const std::complex<float> &z) { return NewtonStepN<N>(z); });
+}
+
+template <typename Output>
+using NewtonKernel = void (*)(float, float, float, float, int, int, int, const Output &,
+                              const std::unique_ptr<float[]> &, const std::unique_ptr<float[]> &, int,
+                              const ispc::RootIndex &);
+
+// Root counts with a specialized kernel; anything else runs the generic one
+constexpr int MIN_SPECIALIZED_ROOTS = 2;
+constexpr int MAX_SPECIALIZED_ROOTS = 16;
+
+template <typename Output, int... I>
+constexpr std::array<NewtonKernel<Output>, sizeof...(I)> makeNewtonKernels(std::integer_sequence<int, I...>) {
+    return {&newton_cxx_n<MIN_SPECIALIZED_ROOTS + I, Output>...};
+}
+
+/**
+ * z^n - 1 over the image, writing through `out`.
+ */
+template <typename Output>
+void render_unity_cxx(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
+                      const int HEIGHT, const int MAX_ITERS, const Output &out, const std::unique_ptr<float[]> &real,
+                      const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                      const ispc::IterationMethod method) {
+    // Newton: specialized kernels for the common root counts
+    static constexpr auto kernels = makeNewtonKernels<Output>(
+        std::make_integer_sequence<int, MAX_SPECIALIZED_ROOTS - MIN_SPECIALIZED_ROOTS + 1>{});
+    if (method == ispc::METHOD_NEWTON && n_roots >= MIN_SPECIALIZED_ROOTS && n_roots <= MAX_SPECIALIZED_ROOTS) {
+        kernels[n_roots - MIN_SPECIALIZED_ROOTS](x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, out, real,
+                                                 imag, n_roots, index);
+        return;
+    }
+    withIterationStep(n_roots, nullptr, method, [&](const auto &step) {
+        render_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, out, real, imag, n_roots, index, step);
+    });
+}
+
+/**
+ * General polynomial over the image, writing through `out`.
+ */
+template <typename Output>
+void render_poly_cxx(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
+                     const int HEIGHT, const int MAX_ITERS, const Output &out, const std::unique_ptr<float[]> &real,
+                     const std::unique_ptr<float[]> &imag, const ispc::RootIndex &index, const ispc::Polynomial &poly,
+                     const ispc::IterationMethod method) {
+    withIterationStep(poly.degree, &poly, method, [&](const auto &step) {
+        render_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, out, real, imag, poly.degree, index, step);
+    });
 }
 
 inline void newton_cxx(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
                        const int HEIGHT, const int MAX_ITERS, std::unique_ptr<int[]> &iters,
                        std::unique_ptr<int[]> &found_roots, const std::unique_ptr<float[]> &real,
-                       const std::unique_ptr<float[]> &imag, const int n_roots) {
+                       const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                       const ispc::IterationMethod method) {
+    render_unity_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, WideOutput{iters.get(), found_roots.get()},
+                     real, imag, n_roots, index, method);
+}
+
+/**
+ * General polynomial version: found_roots == poly.degree marks no root.
+ */
+inline void newton_poly_cxx(const float x_min, const float y_min, const float x_max, const float y_max,
+                            const int WIDTH, const int HEIGHT, const int MAX_ITERS, std::unique_ptr<int[]> &iters,
+                            std::unique_ptr<int[]> &found_roots, const std::unique_ptr<float[]> &real,
+                            const std::unique_ptr<float[]> &imag, const ispc::RootIndex &index,
+                            const ispc::Polynomial &poly, const ispc::IterationMethod method) {
+    render_poly_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, WideOutput{iters.get(), found_roots.get()},
+                    real, imag, index, poly, method);
+}
+
+/**
+ * z^n - 1 (poly == nullptr) or a general polynomial over the image, writing through `out`.
+ */
+template <typename Output>
+void render_any_cxx(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
+                    const int HEIGHT, const int MAX_ITERS, const Output &out, const std::unique_ptr<float[]> &real,
+                    const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                    const ispc::Polynomial *poly, const ispc::IterationMethod method) {
+    if (poly != nullptr)
+        render_poly_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, out, real, imag, index, *poly, method);
+    else
+        render_unity_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, out, real, imag, n_roots, index, method);
+}
+
+/**
+ * Packed-output version of newton_cxx / newton_poly_cxx (poly == nullptr selects z^n - 1): one 16-bit word per
+ * pixel, so n_roots must stay below 256 and MAX_ITERS at most 256.
+ */
+inline void newton_packed_cxx(const float x_min, const float y_min, const float x_max, const float y_max,
+                              const int WIDTH, const int HEIGHT, const int MAX_ITERS,
+                              std::unique_ptr<uint16_t[]> &packed, const std::unique_ptr<float[]> &real,
+                              const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                              const ispc::Polynomial *poly, const ispc::IterationMethod method) {
+    render_any_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, PackedOutput{packed.get()}, real, imag,
+                   n_roots, index, poly, method);
+}
+
+/**
+ * Colouring version: writes the final image, three bytes per pixel, instead of iters / found_roots. palette is the
+ * table palette_ispc() builds for n_roots and MAX_ITERS.
+ */
+inline void newton_rgb_cxx(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
+                           const int HEIGHT, const int MAX_ITERS, std::unique_ptr<uint8_t[]> &rgb,
+                           const uint8_t *palette, const std::unique_ptr<float[]> &real,
+                           const std::unique_ptr<float[]> &imag, const int n_roots, const ispc::RootIndex &index,
+                           const ispc::Polynomial *poly, const ispc::IterationMethod method) {
+    render_any_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, MAX_ITERS, RgbOutput{rgb.get(), palette, MAX_ITERS},
+                   real, imag, n_roots, index, poly, method);
+}
+
+/**
+ * Runs `step` on the pixels with found_roots == n_roots from start_iter up to MAX_ITERS, see newton_continue_cxx.
+ */
+template <typename Step>
+void continue_cxx(const float x_min, const float y_min, const float x_max, const float y_max, const int WIDTH,
+                  const int HEIGHT, const int start_iter, const int MAX_ITERS, std::unique_ptr<int[]> &iters,
+                  std::unique_ptr<int[]> &found_roots, std::unique_ptr<float[]> &z_re, std::unique_ptr<float[]> &z_im,
+                  const std::unique_ptr<float[]> &real, const std::unique_ptr<float[]> &imag, const int n_roots,
+                  const ispc::RootIndex &index, const Step &step) {
+    const float dx = (x_max - x_min) / static_cast<float>(WIDTH);
+    const float dy = (y_max - y_min) / static_cast<float>(HEIGHT);
+    const WideOutput out{iters.get(), found_roots.get()};
+
+    for (int idx = 0; idx < WIDTH * HEIGHT; ++idx) {
+        if (found_roots[idx] != n_roots)
+            continue;
+        std::complex z{x_min + static_cast<float>(idx % WIDTH) * dx, y_min + static_cast<float>(idx / WIDTH) * dy};
+        if (start_iter > 0)
+            z = {z_re[idx], z_im[idx]};
+        perform_newton_from_cxx(z, start_iter, MAX_ITERS, idx, out, real, imag, n_roots, index, step);
+        if (found_roots[idx] == n_roots) {
+            z_re[idx] = z.real();
+            z_im[idx] = z.imag();
+        }
+    }
+}
+
+/**
+ * Resumable version, see newton_ispc_continue: runs only the pixels with found_roots == n_roots, from the z left in
+ * z_re / z_im after start_iter steps (from their coordinates for start_iter == 0) up to MAX_ITERS, and leaves the
+ * last z of the pixels still without a root. poly == nullptr selects z^n - 1.
+ */
+inline void newton_continue_cxx(const float x_min, const float y_min, const float x_max, const float y_max,
+                                const int WIDTH, const int HEIGHT, const int start_iter, const int MAX_ITERS,
+                                std::unique_ptr<int[]> &iters, std::unique_ptr<int[]> &found_roots,
+                                std::unique_ptr<float[]> &z_re, std::unique_ptr<float[]> &z_im,
+                                const std::unique_ptr<float[]> &real, const std::unique_ptr<float[]> &imag,
+                                const int n_roots, const ispc::RootIndex &index, const ispc::Polynomial *poly,
+                                const ispc::IterationMethod method) {
+    withIterationStep(n_roots, poly, method, [&](const auto &step) {
+        continue_cxx(x_min, y_min, x_max, y_max, WIDTH, HEIGHT, start_iter, MAX_ITERS, iters, found_roots, z_re, z_im,
+                     real, imag, n_roots, index, step);
+    });
+}
+
+/**
+ * Runs the serial engine over the image and counts the pixels by Newton steps performed: entry s holds the
+ * pixels that took s steps, for s = 0 ... MAX_ITERS.
+ */
+template <typename Step>
+std::vector<int> stepHistogram(const float x_min, const float y_min, const float x_max, const float y_max,
+                               const int WIDTH, const int HEIGHT, const int MAX_ITERS,
+                               const std::unique_ptr<float[]> &real, const std::unique_ptr<float[]> &imag,
+                               const int n_roots, const ispc::RootIndex &index, const Step &step) {
     const float dx = (x_max - x_min) / static_cast<float>(WIDTH);
     const float dy = (y_max - y_min) / static_cast<float>(HEIGHT);
+    std::vector<int> histogram(MAX_ITERS + 1, 0);
 
     for (int j = 0; j < HEIGHT; ++j) {
         for (int i = 0; i < WIDTH; ++i) {
             const float x = x_min + static_cast<float>(i) * dx;
             const float y = y_min + static_cast<float>(j) * dy;
-
-            const int idx = j * WIDTH + i;
-            perform_newton_cxx(x, y, MAX_ITERS, idx, iters, found_roots, real, imag, n_roots);
+            ++histogram[perform_newton_cxx(x, y, MAX_ITERS, 0, [](int, int, int) {}, real, imag, n_roots, index, step)];
         }
     }
+    return histogram;
 }
 
 #endif // NEWTON_CXX_H
@@ -0,0 +1,153 @@
+//
+// Created by Mateusz Mikiciuk on 25/10/2025.
+//
+
+#ifndef ROOT_INDEX_H
+#define ROOT_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "newton.h"
+
+/**
+ * Owns an ispc::RootIndex and the cell lists it points to.
+ * The index is shared by the ISPC kernels and the C++ engine.
+ */
+class RootLookup {
+  public:
+    // Covers the 1e-6 componentwise convergence tolerance used by the kernels.
+    static constexpr float CAPTURE = 2e-6f;
+
+    RootLookup(const RootLookup &) = delete;
+    RootLookup &operator=(const RootLookup &) = delete;
+    RootLookup(RootLookup &&) = default;
+    RootLookup &operator=(RootLookup &&) = default;
+
+    /**
+     * Roots are the n-th roots of unity in initRoots() order: O(1) lookup from arg(z).
+     */
+    static RootLookup unity(const float capture = CAPTURE) {
+        RootLookup lookup;
+        lookup.index_.kind = ispc::ROOTS_UNITY;
+        lookup.index_.capture = capture;
+        return lookup;
+    }
+
+    /**
+     * Arbitrary roots: each root is binned into every grid cell its capture square touches,
+     * so a lookup only has to scan the cell z falls into.
+     */
+    static RootLookup grid(const float *real, const float *imag, const int n_roots, const float capture = CAPTURE) {
+        RootLookup lookup;
+        ispc::RootIndex &index = lookup.index_;
+
+        float x_lo = real[0], x_hi = real[0], y_lo = imag[0], y_hi = imag[0];
+        for (int i = 1; i < n_roots; ++i) {
+            x_lo = std::min(x_lo, real[i]);
+            x_hi = std::max(x_hi, real[i]);
+            y_lo = std::min(y_lo, imag[i]);
+            y_hi = std::max(y_hi, imag[i]);
+        }
+        x_lo -= capture, x_hi += capture, y_lo -= capture, y_hi += capture;
+
+        // About two cells per root along each axis keeps the cell lists short.
+        const int cells = static_cast<int>(std::ceil(std::sqrt(4.0f * static_cast<float>(n_roots))));
+        const float cell = std::max(std::max(x_hi - x_lo, y_hi - y_lo) / static_cast<float>(cells), 2.0f * capture);
+
+        index.kind = ispc::ROOTS_GRID;
+        index.capture = capture;
+        index.x0 = x_lo;
+        index.y0 = y_lo;
+        index.inv_cell = 1.0f / cell;
+        index.nx = std::max(1, static_cast<int>(std::ceil((x_hi - x_lo) * index.inv_cell)));
+        index.ny = std::max(1, static_cast<int>(std::ceil((y_hi - y_lo) * index.inv_cell)));
+
+        const auto cell_range = [&](const float lo, const float hi, const float origin, const int n) {
+            const int a = static_cast<int>(std::floor((lo - origin) * index.inv_cell));
+            const int b = static_cast<int>(std::floor((hi - origin) * index.inv_cell));
+            return std::pair{std::clamp(a, 0, n - 1), std::clamp(b, 0, n - 1)};
+        };
+        const auto for_each_cell = [&](const int r, auto &&fn) {
+            const auto [cx0, cx1] = cell_range(real[r] - capture, real[r] + capture, index.x0, index.nx);
+            const auto [cy0, cy1] = cell_range(imag[r] - capture, imag[r] + capture, index.y0, index.ny);
+            for (int cy = cy0; cy <= cy1; ++cy)
+                for (int cx = cx0; cx <= cx1; ++cx)
+                    fn(cy * index.nx + cx);
+        };
+
+        std::vector<int> &start = lookup.cell_start_;
+        start.assign(index.nx * index.ny + 1, 0);
+        for (int r = 0; r < n_roots; ++r)
+            for_each_cell(r, [&](const int c) { ++start[c + 1]; });
+        for (size_t c = 1; c < start.size(); ++c)
+            start[c] += start[c - 1];
+
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        lookup.cell_roots_.resize(start.back());
+        for (int r = 0; r < n_roots; ++r)
+            for_each_cell(r, [&](const int c) { lookup.cell_roots_[fill[c]++] = r; });
+
+        index.cell_start = start.data();
+        index.cell_roots = lookup.cell_roots_.data();
+        return lookup;
+    }
+
+    /**
+     * Turns on the trap with one squared radius per root; the capture must cover the largest radius.
+     */
+    void setTrap(std::vector<float> trap_r2) {
+        trap_r2_ = std::move(trap_r2);
+        index_.trap_r2 = trap_r2_.data();
+    }
+
+    ispc::RootIndex &index() { return index_; }
+    const ispc::RootIndex &index() const { return index_; }
+
+  private:
+    RootLookup() = default;
+
+    ispc::RootIndex index_{};
+    std::vector<int> cell_start_;
+    std::vector<int> cell_roots_;
+    std::vector<float> trap_r2_;
+};
+
+/**
+ * C++ counterpart of root_candidate() in roots.ispc: the id of the only root
+ * that can lie within index.capture of z, or -1.
+ */
+inline int rootCandidate(const ispc::RootIndex &index, const std::complex<float> &z, const float *real,
+                         const float *imag, const int n_roots) {
+    if (index.kind == ispc::ROOTS_UNITY) {
+        const float r2 = std::norm(z);
+        if (std::abs(r2 - 1.0f) >= index.capture * (2.0f + index.capture))
+            return -1;
+        const float scale = static_cast<float>(n_roots) / (2.0f * static_cast<float>(M_PI));
+        const int k = static_cast<int>(std::round(std::arg(z) * scale));
+        return k < 0 ? k + n_roots : k;
+    }
+
+    const float fx = std::floor((z.real() - index.x0) * index.inv_cell);
+    const float fy = std::floor((z.imag() - index.y0) * index.inv_cell);
+    // written so that a NaN z fails the test too
+    if (!(fx >= 0 && fy >= 0 && fx < static_cast<float>(index.nx) && fy < static_cast<float>(index.ny)))
+        return -1;
+
+    const int cell = static_cast<int>(fy) * index.nx + static_cast<int>(fx);
+    float best = index.capture * index.capture;
+    int k = -1;
+    for (int c = index.cell_start[cell]; c < index.cell_start[cell + 1]; ++c) {
+        const int r = index.cell_roots[c];
+        const float d2 = std::norm(z - std::complex{real[r], imag[r]});
+        if (d2 < best) {
+            best = d2;
+            k = r;
+        }
+    }
+    return k;
+}
+
+#endif // ROOT_INDEX_H
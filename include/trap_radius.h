@@ -0,0 +1,87 @@
+//
+// Created by Mateusz Mikiciuk on 28/10/2025.
+//
+
+#ifndef TRAP_RADIUS_H
+#define TRAP_RADIUS_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "newton.h"
+
+/**
+ * Smale's gamma of z^n - 1 at any of its roots: max over k >= 2 of (C(n,k) / n)^(1/(k-1)),
+ * since f^(k)(r) / (k! f'(r)) = C(n,k) r^(1-k) / n and |r| = 1.
+ */
+inline double unityGamma(const int n) {
+    double gamma = 0.0;
+    double binom = n; // C(n, k - 1)
+    for (int k = 2; k <= n; ++k) {
+        binom = binom * (n - k + 1) / k;
+        gamma = std::max(gamma, std::pow(binom / n, 1.0 / (k - 1)));
+    }
+    return gamma;
+}
+
+/**
+ * Smale's gamma of a general polynomial at the root r: max over k >= 2 of |a_k / a_1|^(1/(k-1)), with a_k
+ * the Taylor coefficients at r, found by repeated synthetic division by (z - r).
+ * Infinite for a multiple root.
+ */
+inline double polyGamma(const ispc::Polynomial &poly, const std::complex<double> r) {
+    std::vector<std::complex<double>> c(poly.degree + 1);
+    for (int k = 0; k <= poly.degree; ++k)
+        c[k] = {poly.re[k], poly.im[k]};
+
+    std::vector<std::complex<double>> taylor(poly.degree + 1);
+    for (int k = 0; k <= poly.degree; ++k) {
+        // after this pass c[k] holds p^(k)(r) / k! and c[k+1 ...] the next quotient
+        for (int i = poly.degree - 1; i >= k; --i)
+            c[i] += r * c[i + 1];
+        taylor[k] = c[k];
+    }
+
+    const double a1 = std::abs(taylor[1]);
+    if (a1 == 0.0)
+        return INFINITY;
+    double gamma = 0.0;
+    for (int k = 2; k <= poly.degree; ++k)
+        gamma = std::max(gamma, std::pow(std::abs(taylor[k]) / a1, 1.0 / (k - 1)));
+    return gamma;
+}
+
+/**
+ * Largest distance from a root at which one Newton step is guaranteed to land within `target` of it.
+ * By the gamma theorem the step maps d to at most gamma d^2 / psi(u), u = gamma d, psi(u) = 1 - 4u + 2u^2,
+ * for u below (5 - sqrt(17)) / 4; the radius solves u^2 = c psi(u) with c = gamma target.
+ */
+inline double trapRadius(const double gamma, const double target) {
+    if (!std::isfinite(gamma))
+        return 0.0;
+    if (gamma == 0.0) // linear: Newton is exact
+        return INFINITY;
+    const double c = gamma * target;
+    const double u = (-4.0 * c + std::sqrt(16.0 * c * c + 4.0 * c * (1.0 - 2.0 * c))) / (2.0 * (1.0 - 2.0 * c));
+    return std::min(u, (5.0 - std::sqrt(17.0)) / 4.0) / gamma;
+}
+
+/**
+ * Squared trap radius per root. The step has to land within half the 1e-6 tolerance,
+ * the other half is left for float rounding in the step and in the stored roots.
+ */
+inline std::vector<float> trapRadii2(const float *real, const float *imag, const int n_roots,
+                                     const ispc::Polynomial *poly) {
+    constexpr double target = 0.5e-6;
+    std::vector<float> r2(n_roots);
+    for (int k = 0; k < n_roots; ++k) {
+        const double gamma = poly != nullptr ? polyGamma(*poly, {real[k], imag[k]}) : unityGamma(n_roots);
+        const double r = std::min(trapRadius(gamma, target), 0.1);
+        r2[k] = static_cast<float>(r * r);
+    }
+    return r2;
+}
+
+#endif // TRAP_RADIUS_H
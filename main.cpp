@@ -1,16 +1,42 @@
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
-#include "colours.h"
+#include "basin_query.h"
+#include "deep.h"
+#include "deep_cxx.h"
+#include "double_double_cxx.h"
 #include "newton.h"
+#include "palette.h"
+#include "pan.h"
+#include "progressive.h"
+#include "stats.h"
+#include "poly_roots.h"
 #include "newton_cxx.h"
+#include "root_index.h"
+#include "subdivide.h"
+#include "supersample.h"
+#include "symmetry.h"
+#include "target_info.h"
 #include "timing.h"
+#include "trap_radius.h"
 
 void usage(const std::string &pname) {
-    std::cerr << "USAGE: " << pname << " [--n=<value>]\n";
+    std::cerr << "USAGE: " << pname << " [--n=<value>] [--max-iters=<value>] [--poly=<c0,c1,...,cn>] [--lookup=unity|grid] [--compact]\n"
+              << "       [--trap] [--check-every=<k>] [--method=newton|halley|schroder]\n"
+              << "       [--layout=rows|tiled] [--footprint=strip|tiled|block] [--bench-footprints] [--output=wide|packed|rgb]\n"
+              << "       [--refine=<iters>] [--subdivide=<band>] [--symmetry] [--supersample=<k>]\n"
+              << "       [--progressive=<mcycles>] [--pan=<px>,<py>] [--zoom=<frames>]\n"
+              << "       [--query=<points>] [--stats] [--task-tile=<w>x<h>] [--sweep-tiles]\n"
+              << "       [--view=<cx>,<cy>,<half-width>] [--precision=auto|float|double|dd]\n";
     exit(EXIT_FAILURE);
 }
 
@@ -32,13 +58,109 @@ constexpr float Y_MAX = 2.5f;
 // Tests settings
 // --------------
 constexpr int TEST_ITERS = 3;
+constexpr int MAX_ROOT_SWEEPS = 500;
+constexpr int DEEP_TILE = 32;
+constexpr int OUTPUT_TILE = 32;
+constexpr int PROGRESSIVE_STEP = 8;
+constexpr int PROGRESSIVE_LEVELS = 4; // steps 8, 4, 2, 1
+constexpr float ZOOM_FACTOR = 0.9f;
+
+/**
+ * Root k of z^n - 1. Roots past the first octant are reflections of one inside it, so the table is exactly
+ * symmetric under conjugation, under z -> -conj z for even n and under z -> i conj z for n divisible by 4,
+ * which the symmetric render relies on.
+ */
+void unityRoot(const int k, const int n_roots, float &re, float &im) {
+    if (2 * k > n_roots) { // conj
+        unityRoot(n_roots - k, n_roots, re, im);
+        im = -im;
+    } else if (n_roots % 2 == 0 && 4 * k > n_roots) { // -conj
+        unityRoot(n_roots / 2 - k, n_roots, re, im);
+        re = -re;
+    } else if (n_roots % 4 == 0 && 8 * k > n_roots) { // i conj
+        unityRoot(n_roots / 4 - k, n_roots, im, re);
+    } else {
+        const float angle = M_PI * 2.0f * k / n_roots;
+        re = cos(angle);
+        im = sin(angle);
+    }
+}
 
 void initRoots(const std::unique_ptr<float[]> &real, const std::unique_ptr<float[]> &imag, const int n_roots) {
     for (int k = 0; k < n_roots; ++k) {
-        const float angle = M_PI * 2.0f * k / n_roots;
-        real[k] = cos(angle);
-        imag[k] = sin(angle);
+        unityRoot(k, n_roots, real[k], imag[k]);
+    }
+}
+
+/**
+ * Parses a comma-separated list of real coefficients c0,c1,...,cn (c_k multiplies z^k).
+ */
+std::vector<float> parseCoefficients(const char *list) {
+    std::vector<float> coefs;
+    char *end = nullptr;
+    for (const char *s = list; *s != '\0'; s = end + (*end == ',')) {
+        coefs.push_back(strtof(s, &end));
+        if (end == s || (*end != ',' && *end != '\0') || (*end == ',' && end[1] == '\0')) {
+            return {};
+        }
+    }
+    while (!coefs.empty() && coefs.back() == 0.0f) {
+        coefs.pop_back();
+    }
+    return coefs;
+}
+
+/**
+ * Parses <cx>,<cy>,<half-width>; the centre keeps full double-double precision.
+ */
+bool parseView(const char *s, DoubleDouble &cx, DoubleDouble &cy, double &half_width) {
+    const char *end = nullptr;
+    cx = parseDoubleDouble(s, &end);
+    if (end == s || *end != ',') {
+        return false;
+    }
+    s = end + 1;
+    cy = parseDoubleDouble(s, &end);
+    if (end == s || *end != ',') {
+        return false;
+    }
+    s = end + 1;
+    char *r_end = nullptr;
+    half_width = strtod(s, &r_end);
+    return r_end != s && *r_end == '\0' && half_width > 0.0;
+}
+
+/**
+ * Row costs of the next frame of a zoom by factor about the image centre: row y of the next frame sees what row
+ * HEIGHT / 2 + (y - HEIGHT / 2) * factor of this one saw.
+ */
+std::vector<int> zoomRowCosts(const std::vector<int> &cost, const float factor) {
+    std::vector<int> next(HEIGHT);
+    for (int y = 0; y < HEIGHT; ++y) {
+        const int src = HEIGHT / 2 + static_cast<int>(std::lround((y - HEIGHT / 2) * factor));
+        next[y] = cost[std::clamp(src, 0, HEIGHT - 1)];
     }
+    return next;
+}
+
+/**
+ * Cuts the rows into n_bands runs of about equal total cost; band_start gets n_bands + 1 entries, the last HEIGHT.
+ */
+void partitionRows(const std::vector<int> &cost, const int n_bands, std::vector<int> &band_start) {
+    int64_t total = 0;
+    for (const int c : cost) {
+        total += c;
+    }
+    int64_t prefix = 0;
+    int y = 0;
+    band_start[0] = 0;
+    for (int b = 1; b < n_bands; ++b) {
+        while (y < HEIGHT && prefix + cost[y] <= total * b / n_bands) {
+            prefix += cost[y++];
+        }
+        band_start[b] = y;
+    }
+    band_start[n_bands] = HEIGHT;
 }
 
 void clearBuff(std::unique_ptr<int[]> &iters, std::unique_ptr<int[]> &found_roots) {
@@ -46,95 +168,1026 @@ void clearBuff(std::unique_ptr<int[]> &iters, std::unique_ptr<int[]> &found_root
     found_roots.reset(new int[BUF_N]);
 }
 
-void writePPM(const std::unique_ptr<int[]> &iters, const std::unique_ptr<int[]> &found_roots, const int size,
-              const std::string &fn) {
+/**
+ * Writes a coloured image: the buffer holds three bytes per pixel and is the PPM body.
+ */
+void writePPM(const std::unique_ptr<uint8_t[]> &rgb, const std::string &fn) {
     std::ofstream ofs(fn, std::ios::binary);
     if (!ofs.is_open()) {
         throw std::runtime_error("Could not open file " + fn);
     }
 
     ofs << "P6\n" << WIDTH << ' ' << HEIGHT << "\n255\n";
+    ofs.write(reinterpret_cast<const char *>(rgb.get()), 3 * BUF_N);
+
+    std::cout << "Wrote image file " << fn << '\n';
+}
+
+/**
+ * Average number of steps per pixel: iters + 1 for a converged pixel, max_iters for the others.
+ */
+double averageIterations(const std::unique_ptr<int[]> &iters, const std::unique_ptr<int[]> &found_roots,
+                         const int size, const int max_iters) {
+    double sum = 0.0;
     for (int i = 0; i < BUF_N; ++i) {
-        RGB c = {0, 0, 0};
+        sum += found_roots[i] < size ? iters[i] + 1 : max_iters;
+    }
+    return sum / BUF_N;
+}
 
-        if (found_roots[i] < size) {
-            const float H = static_cast<float>(found_roots[i]) / static_cast<float>(size);
-            const float V = 1.0f - static_cast<float>(iters[i]) / static_cast<float>(MAX_ITERS);
-            c = HSVtoRGB(H, 1.0f, V);
-        }
-        ofs.put(static_cast<char>(c.r));
-        ofs.put(static_cast<char>(c.g));
-        ofs.put(static_cast<char>(c.b));
+double averageIterations(const std::unique_ptr<uint16_t[]> &packed, const int size, const int max_iters) {
+    double sum = 0.0;
+    for (int i = 0; i < BUF_N; ++i) {
+        sum += (packed[i] >> 8) < size ? (packed[i] & 0xff) + 1 : max_iters;
     }
+    return sum / BUF_N;
+}
 
-    std::cout << "Wrote image file " << fn << '\n';
+const char *isaName(const ispc::TargetIsa isa) {
+    switch (isa) {
+    case ispc::ISA_SSE2:
+        return "sse2";
+    case ispc::ISA_SSE4:
+        return "sse4";
+    case ispc::ISA_AVX:
+        return "avx";
+    case ispc::ISA_AVX2:
+        return "avx2";
+    case ispc::ISA_AVX512KNL:
+        return "avx512knl";
+    case ispc::ISA_AVX512SKX:
+        return "avx512skx";
+    case ispc::ISA_AVX512SPR:
+        return "avx512spr";
+    case ispc::ISA_NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
 }
 
+// Result buffers the engines write, see --output
+enum class OutputFormat { Wide, Packed, Rgb };
+
 using namespace ispc;
 
+/**
+ * Pixels whose iteration count or root differs between two renders of size pixels.
+ */
+int countDiffering(const int *iters_a, const int *found_roots_a, const int *iters_b, const int *found_roots_b,
+                   const int size) {
+    int differ = 0;
+    for (int i = 0; i < size; ++i) {
+        differ += iters_a[i] != iters_b[i] || found_roots_a[i] != found_roots_b[i];
+    }
+    return differ;
+}
+
+/**
+ * Pixels whose colour differs between two images of BUF_N pixels, three bytes each.
+ */
+int countDiffering(const uint8_t *rgb_a, const uint8_t *rgb_b) {
+    int differ = 0;
+    for (int i = 0; i < BUF_N; ++i) {
+        differ += rgb_a[3 * i] != rgb_b[3 * i] || rgb_a[3 * i + 1] != rgb_b[3 * i + 1] ||
+                  rgb_a[3 * i + 2] != rgb_b[3 * i + 2];
+    }
+    return differ;
+}
+
+/**
+ * What the comparison modes below share: the function iterated, the engine settings and the render of the ISPC
+ * tasks engine they are checked against.
+ */
+struct BenchSetup {
+    int n;
+    int max_iters;
+    const std::unique_ptr<float[]> &real;
+    const std::unique_ptr<float[]> &imag;
+    RootIndex &index;
+    Polynomial *poly; // nullptr for z^n - 1
+    int check_every;
+    IterationMethod method;
+    GangFootprint footprint;
+    int tile_w, tile_h;
+    uint8_t *palette;
+    int *iters; // the ISPC tasks render, null unless --output=wide
+    int *found_roots;
+    const std::unique_ptr<uint8_t[]> &image; // colourizing scratch, 3 * BUF_N bytes
+};
+
+/**
+ * Histogram of the steps the serial engine performs per pixel, without and with the root traps (--trap).
+ */
+void benchTrapSteps(const BenchSetup &s) {
+    const auto histogram = [&s](const RootIndex &index) {
+        std::vector<int> steps;
+        withIterationStep(s.n, s.poly, METHOD_NEWTON, [&](const auto &step) {
+            steps = stepHistogram(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters, s.real, s.imag, s.n, index,
+                                  step);
+        });
+        return steps;
+    };
+    RootIndex untrapped = s.index;
+    untrapped.trap_r2 = nullptr;
+    const std::vector<int> before = histogram(untrapped);
+    const std::vector<int> after = histogram(s.index);
+
+    double sum_before = 0.0, sum_after = 0.0;
+    std::cout << "@steps histogram:\t\t\t[steps: without trap, with trap]\n";
+    for (int step = 0; step <= s.max_iters; ++step) {
+        sum_before += static_cast<double>(step) * before[step];
+        sum_after += static_cast<double>(step) * after[step];
+        if (before[step] != 0 || after[step] != 0) {
+            std::cout << "\t\t\t\t\t" << step << ": " << before[step] << ", " << after[step] << '\n';
+        }
+    }
+    std::cout << "@average steps per pixel:\t[" << sum_before / BUF_N << " -> " << sum_after / BUF_N << "]\n";
+}
+
+/**
+ * Mariani-Silver subdivision (--subdivide): time, share of pixels iterated and pixels that differ from the full
+ * render.
+ */
+void benchSubdivide(const BenchSetup &s, const int band) {
+    std::unique_ptr<int[]> sub_iters;
+    std::unique_ptr<int[]> sub_found_roots;
+    double min_subdivide = 1e30;
+    int computed = 0;
+    for (int i = 0; i < TEST_ITERS; ++i) {
+        clearBuff(sub_iters, sub_found_roots);
+        reset_and_start_timer();
+        computed = newton_ispc_subdivide_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters, sub_iters.get(),
+                                               sub_found_roots.get(), s.real.get(), s.imag.get(), s.n, &s.index,
+                                               s.poly, s.check_every, s.method, band);
+        min_subdivide = std::min(min_subdivide, get_elapsed_mcycles());
+    }
+    colourize_ispc_tasks(sub_iters.get(), sub_found_roots.get(), s.palette, s.max_iters, BUF_N, s.image.get());
+    writePPM(s.image, "../images/newton_subdivide.ppm");
+    std::cout << "@newton subdivide best:\t\t[" << min_subdivide << "] million cycles, " << 100.0 * computed / BUF_N
+              << "% of pixels iterated\n";
+    if (s.iters != nullptr) {
+        std::cout << "@subdivide vs ISPC tasks:\t["
+                  << countDiffering(sub_iters.get(), sub_found_roots.get(), s.iters, s.found_roots, BUF_N)
+                  << "] pixels differ\n";
+    }
+}
+
+/**
+ * z^n - 1 from the fundamental domain of the reflections the grid respects, the rest filled by remapping root ids
+ * (--symmetry).
+ */
+void benchSymmetric(const BenchSetup &s) {
+    GridSymmetry sym;
+    newton_grid_symmetry(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.n, &sym);
+    std::unique_ptr<int[]> sym_iters;
+    std::unique_ptr<int[]> sym_found_roots;
+    double min_symmetric = 1e30;
+    for (int i = 0; i < TEST_ITERS; ++i) {
+        clearBuff(sym_iters, sym_found_roots);
+        reset_and_start_timer();
+        newton_ispc_symmetric_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters, sym_iters.get(),
+                                    sym_found_roots.get(), s.real.get(), s.imag.get(), s.n, &s.index, s.check_every,
+                                    s.method, &sym);
+        min_symmetric = std::min(min_symmetric, get_elapsed_mcycles());
+    }
+    colourize_ispc_tasks(sym_iters.get(), sym_found_roots.get(), s.palette, s.max_iters, BUF_N, s.image.get());
+    writePPM(s.image, "../images/newton_symmetric.ppm");
+    std::cout << "@symmetries:\t\t\t\t[" << (sym.conjugate ? "conjugate " : "") << (sym.mirror ? "mirror " : "")
+              << (sym.diagonal ? "diagonal" : "") << "]\n";
+    std::cout << "@newton symmetric best:\t\t[" << min_symmetric << "] million cycles\n";
+    if (s.iters != nullptr) {
+        std::cout << "@symmetric vs ISPC tasks:\t["
+                  << countDiffering(sym_iters.get(), sym_found_roots.get(), s.iters, s.found_roots, BUF_N)
+                  << "] pixels differ\n";
+    }
+}
+
+/**
+ * k x k samples only where neighbours disagree on the root or jump in iterations, against every pixel
+ * (--supersample).
+ */
+void benchSupersample(const BenchSetup &s, const int samples) {
+    const int iter_jump = std::max(s.max_iters / 8, 1);
+    std::vector<int> edges(BUF_N);
+    std::vector<int> sample_iters(BUF_N);
+    std::vector<int> sample_roots(BUF_N);
+    reset_and_start_timer();
+    const int n_edges = newton_edge_pixels(WIDTH, HEIGHT, s.iters, s.found_roots, iter_jump, edges.data());
+    const double dt_mark = get_elapsed_mcycles();
+
+    double min_supersample = 1e30;
+    for (int i = 0; i < TEST_ITERS; ++i) {
+        colourize_ispc_tasks(s.iters, s.found_roots, s.palette, s.max_iters, BUF_N, s.image.get());
+        reset_and_start_timer();
+        newton_ispc_supersample_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters, s.real.get(),
+                                      s.imag.get(), s.n, &s.index, s.poly, s.check_every, s.method, samples,
+                                      edges.data(), n_edges, sample_iters.data(), sample_roots.data(), s.palette,
+                                      s.image.get());
+        min_supersample = std::min(min_supersample, get_elapsed_mcycles());
+    }
+    writePPM(s.image, "../images/newton_supersample.ppm");
+    std::cout << "@edge pixels:\t\t\t\t[" << n_edges << "] (" << 100.0 * n_edges / BUF_N << "%), marked in "
+              << dt_mark << " million cycles\n";
+    std::cout << "@newton supersample best:\t[" << min_supersample << "] million cycles, " << samples << "x"
+              << samples << " samples\n";
+
+    // The same samples for every pixel, once
+    const std::unique_ptr<uint8_t[]> full(new uint8_t[3 * BUF_N]);
+    std::iota(edges.begin(), edges.end(), 0);
+    colourize_ispc_tasks(s.iters, s.found_roots, s.palette, s.max_iters, BUF_N, full.get());
+    reset_and_start_timer();
+    newton_ispc_supersample_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters, s.real.get(), s.imag.get(),
+                                  s.n, &s.index, s.poly, s.check_every, s.method, samples, edges.data(), BUF_N,
+                                  sample_iters.data(), sample_roots.data(), s.palette, full.get());
+    const double dt_full = get_elapsed_mcycles();
+    std::cout << "@supersample every pixel:\t[" << dt_full << "] million cycles, "
+              << countDiffering(s.image.get(), full.get()) << " pixels differ from the adaptive image\n";
+}
+
+/**
+ * Coarse to fine levels until the next one, at the cost per sample measured so far, would overrun budget million
+ * cycles (--progressive).
+ */
+void benchProgressive(const BenchSetup &s, const double budget) {
+    std::unique_ptr<int[]> prog_iters;
+    std::unique_ptr<int[]> prog_found_roots;
+    clearBuff(prog_iters, prog_found_roots);
+    std::vector<double> level_mcycles(PROGRESSIVE_LEVELS);
+    const int reached = newton_ispc_progressive_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters,
+                                                      prog_iters.get(), prog_found_roots.get(), s.real.get(),
+                                                      s.imag.get(), s.n, &s.index, s.poly, s.check_every, s.method,
+                                                      PROGRESSIVE_STEP, budget, level_mcycles.data());
+    for (int step = PROGRESSIVE_STEP, level = 0; step >= reached; step /= 2, ++level) {
+        std::cout << "@progressive step " << step << ":\t\t[" << level_mcycles[level] << "] million cycles\n";
+    }
+    colourize_ispc_tasks(prog_iters.get(), prog_found_roots.get(), s.palette, s.max_iters, BUF_N, s.image.get());
+    writePPM(s.image, "../images/newton_progressive.ppm");
+    std::cout << "@progressive reached:\t\t[step " << reached << "] within " << budget << " million cycles\n";
+    if (reached == 1 && s.iters != nullptr) {
+        std::cout << "@progressive vs ISPC tasks:\t["
+                  << countDiffering(prog_iters.get(), prog_found_roots.get(), s.iters, s.found_roots, BUF_N)
+                  << "] pixels differ\n";
+    }
+}
+
+/**
+ * The default view moved by whole pixels (--pan): shift the buffers and compute the exposed strips vs render again.
+ */
+void benchPan(const BenchSetup &s, const int pan_x, const int pan_y) {
+    const float dx = (X_MAX - X_MIN) / WIDTH;
+    const float dy = (Y_MAX - Y_MIN) / HEIGHT;
+    const float pan_x_min = X_MIN + static_cast<float>(pan_x) * dx;
+    const float pan_y_min = Y_MIN + static_cast<float>(pan_y) * dy;
+    const float pan_x_max = X_MAX + static_cast<float>(pan_x) * dx;
+    const float pan_y_max = Y_MAX + static_cast<float>(pan_y) * dy;
+    std::unique_ptr<int[]> pan_iters;
+    std::unique_ptr<int[]> pan_found_roots;
+    clearBuff(pan_iters, pan_found_roots);
+    double min_pan = 1e30;
+    int computed = 0;
+    for (int i = 0; i < TEST_ITERS; ++i) {
+        std::copy_n(s.iters, BUF_N, pan_iters.get());
+        std::copy_n(s.found_roots, BUF_N, pan_found_roots.get());
+        reset_and_start_timer();
+        computed = newton_ispc_pan_tasks(pan_x_min, pan_y_min, pan_x_max, pan_y_max, WIDTH, HEIGHT, s.max_iters,
+                                         pan_iters.get(), pan_found_roots.get(), s.real.get(), s.imag.get(), s.n,
+                                         &s.index, s.poly, s.check_every, s.method, pan_x, pan_y);
+        min_pan = std::min(min_pan, get_elapsed_mcycles());
+    }
+    colourize_ispc_tasks(pan_iters.get(), pan_found_roots.get(), s.palette, s.max_iters, BUF_N, s.image.get());
+    writePPM(s.image, "../images/newton_pan.ppm");
+    std::cout << "@newton pan best:\t\t\t[" << min_pan << "] million cycles, " << 100.0 * computed / BUF_N
+              << "% of pixels computed\n";
+
+    // The reused pixels sit on the old grid, which can round differently from the new one near basin boundaries
+    std::unique_ptr<int[]> full_iters;
+    std::unique_ptr<int[]> full_found_roots;
+    clearBuff(full_iters, full_found_roots);
+    reset_and_start_timer();
+    if (s.poly != nullptr) {
+        newton_poly_ispc_tasks(pan_x_min, pan_y_min, pan_x_max, pan_y_max, WIDTH, HEIGHT, s.max_iters,
+                               full_iters.get(), full_found_roots.get(), s.real.get(), s.imag.get(), &s.index, s.poly,
+                               s.check_every, s.method, s.footprint, s.tile_w, s.tile_h);
+    } else {
+        newton_ispc_tasks(pan_x_min, pan_y_min, pan_x_max, pan_y_max, WIDTH, HEIGHT, s.max_iters, full_iters.get(),
+                          full_found_roots.get(), s.real.get(), s.imag.get(), s.n, &s.index, s.check_every, s.method,
+                          s.footprint, s.tile_w, s.tile_h);
+    }
+    const double dt_full = get_elapsed_mcycles();
+    const int differ =
+        countDiffering(pan_iters.get(), pan_found_roots.get(), full_iters.get(), full_found_roots.get(), BUF_N);
+    std::cout << "@full render of the panned view:\t[" << dt_full << "] million cycles, " << differ
+              << " pixels differ\n";
+}
+
+/**
+ * Zoom by ZOOM_FACTOR per frame into the centre of the view, one band of rows per hardware thread (--zoom): equal
+ * bands vs bands cut from the previous frame's row costs, then the latter writing each frame on a second thread
+ * while the next one renders.
+ */
+void benchZoom(const BenchSetup &s, const int frames) {
+    const int n_bands = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    std::vector<int> band_start(n_bands + 1);
+    std::vector<int> row_cost(HEIGHT);
+    std::unique_ptr<int[]> zoom_iters;
+    std::unique_ptr<int[]> zoom_found_roots;
+    clearBuff(zoom_iters, zoom_found_roots);
+    const std::unique_ptr<uint8_t[]> buffers[2] = {std::unique_ptr<uint8_t[]>(new uint8_t[3 * BUF_N]),
+                                                   std::unique_ptr<uint8_t[]>(new uint8_t[3 * BUF_N])};
+    const float cx = 0.5f * (X_MIN + X_MAX);
+    const float cy = 0.5f * (Y_MIN + Y_MAX);
+    const auto sequence = [&](const bool guided, const bool write) {
+        std::thread writer;
+        reset_and_start_timer();
+        for (int f = 0; f < frames; ++f) {
+            if (guided && f > 0) {
+                partitionRows(zoomRowCosts(row_cost, ZOOM_FACTOR), n_bands, band_start);
+            } else {
+                for (int b = 0; b <= n_bands; ++b) {
+                    band_start[b] = b * HEIGHT / n_bands;
+                }
+            }
+            const float scale = std::pow(ZOOM_FACTOR, static_cast<float>(f));
+            const float half_w = 0.5f * (X_MAX - X_MIN) * scale;
+            const float half_h = 0.5f * (Y_MAX - Y_MIN) * scale;
+            newton_ispc_bands_tasks(cx - half_w, cy - half_h, cx + half_w, cy + half_h, WIDTH, HEIGHT, s.max_iters,
+                                    zoom_iters.get(), zoom_found_roots.get(), s.real.get(), s.imag.get(), s.n,
+                                    &s.index, s.poly, s.check_every, s.method, s.footprint, band_start.data(),
+                                    n_bands);
+            if (guided) {
+                newton_row_costs_ispc_tasks(WIDTH, HEIGHT, s.max_iters, zoom_iters.get(), zoom_found_roots.get(), s.n,
+                                            row_cost.data());
+            }
+            if (write) {
+                // frame f - 1 is still being written from the other buffer
+                const std::unique_ptr<uint8_t[]> &frame = buffers[f % 2];
+                colourize_ispc_tasks(zoom_iters.get(), zoom_found_roots.get(), s.palette, s.max_iters, BUF_N,
+                                     frame.get());
+                if (writer.joinable()) {
+                    writer.join();
+                }
+                char fn[64];
+                snprintf(fn, sizeof(fn), "../images/zoom_%03d.ppm", f);
+                writer = std::thread([&frame, fn = std::string(fn)] { writePPM(frame, fn); });
+            }
+        }
+        if (writer.joinable()) {
+            writer.join();
+        }
+        return get_elapsed_mcycles();
+    };
+
+    const double dt_fixed = sequence(false, false);
+    const double dt_guided = sequence(true, false);
+    const double dt_written = sequence(true, true);
+    std::cout << "@zoom equal bands:\t\t\t[" << dt_fixed << "] million cycles for " << frames << " frames, "
+              << n_bands << " bands\n";
+    std::cout << "@zoom cost-guided bands:\t[" << dt_guided << "] million cycles\n";
+    std::cout << "@zoom cost-guided + writing:\t[" << dt_written << "] million cycles\n";
+}
+
+/**
+ * Scattered points of the view (--query): one batched query vs a 1x1 render per point.
+ */
+void benchQuery(const BenchSetup &s, const int n_points) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> along_x(X_MIN, X_MAX), along_y(Y_MIN, Y_MAX);
+    std::vector<float> re(n_points), im(n_points);
+    for (int i = 0; i < n_points; ++i) {
+        re[i] = along_x(rng);
+        im[i] = along_y(rng);
+    }
+
+    reset_and_start_timer();
+    const BasinClassification batch = classifyPoints(re, im, s.max_iters, s.real.get(), s.imag.get(), s.n, s.index,
+                                                      s.poly, s.check_every, s.method);
+    const double dt_batch = get_elapsed_mcycles();
+
+    std::vector<int> point_iters(n_points), point_roots(n_points);
+    reset_and_start_timer();
+    for (int i = 0; i < n_points; ++i) {
+        if (s.poly != nullptr) {
+            newton_poly_ispc(re[i], im[i], re[i] + 1.0f, im[i] + 1.0f, 1, 1, s.max_iters, &point_iters[i],
+                             &point_roots[i], s.real.get(), s.imag.get(), &s.index, s.poly, s.check_every, s.method,
+                             s.footprint);
+        } else {
+            newton_ispc(re[i], im[i], re[i] + 1.0f, im[i] + 1.0f, 1, 1, s.max_iters, &point_iters[i], &point_roots[i],
+                        s.real.get(), s.imag.get(), s.n, &s.index, s.check_every, s.method, s.footprint);
+        }
+    }
+    const double dt_single = get_elapsed_mcycles();
+    std::cout << "@query batch:\t\t\t\t[" << dt_batch << "] million cycles for " << n_points << " points\n";
+    std::cout << "@query 1x1 renders:\t\t\t[" << dt_single << "] million cycles, "
+              << countDiffering(point_iters.data(), point_roots.data(), batch.iters.data(), batch.found_roots.data(),
+                                n_points)
+              << " points differ\n";
+}
+
+/**
+ * Basin areas and iteration histogram counted inside the render, with and without storing the pixels, vs a render
+ * by run_tasks into s.iters / s.found_roots followed by a pass over them (--stats).
+ */
+template <typename RunTasks>
+void benchStats(const BenchSetup &s, const RunTasks &run_tasks) {
+    const int n = s.n;
+    std::vector<int> root_pixels(n + 1), iter_pixels(s.max_iters);
+    RenderStats render_stats{root_pixels.data(), iter_pixels.data()};
+    std::unique_ptr<int[]> stats_iters;
+    std::unique_ptr<int[]> stats_found_roots;
+    clearBuff(stats_iters, stats_found_roots);
+    double min_stats = 1e30, min_stored = 1e30, min_pass = 1e30;
+    std::vector<int> pass_roots(n + 1), pass_iters(s.max_iters);
+    for (int i = 0; i < TEST_ITERS; ++i) {
+        reset_and_start_timer();
+        newton_ispc_stats_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters, stats_iters.get(),
+                                stats_found_roots.get(), s.real.get(), s.imag.get(), n, &s.index, s.poly,
+                                s.check_every, s.method, &render_stats);
+        min_stored = std::min(min_stored, get_elapsed_mcycles());
+
+        reset_and_start_timer();
+        newton_ispc_stats_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, s.max_iters, nullptr, nullptr,
+                                s.real.get(), s.imag.get(), n, &s.index, s.poly, s.check_every, s.method,
+                                &render_stats);
+        min_stats = std::min(min_stats, get_elapsed_mcycles());
+
+        reset_and_start_timer();
+        run_tasks();
+        std::fill(pass_roots.begin(), pass_roots.end(), 0);
+        std::fill(pass_iters.begin(), pass_iters.end(), 0);
+        for (int p = 0; p < BUF_N; ++p) {
+            ++pass_roots[s.found_roots[p]];
+            pass_iters[s.iters[p]] += s.found_roots[p] < n;
+        }
+        min_pass = std::min(min_pass, get_elapsed_mcycles());
+    }
+
+    double sum = static_cast<double>(root_pixels[n]) * s.max_iters;
+    for (int i = 0; i < s.max_iters; ++i) {
+        sum += static_cast<double>(i + 1) * iter_pixels[i];
+    }
+    std::cout << "@basin areas:\t\t\t\t[";
+    for (int k = 0; k <= n; ++k) {
+        std::cout << (k > 0 ? ", " : "") << 100.0 * root_pixels[k] / BUF_N << "%";
+    }
+    std::cout << "] (last: no root)\n";
+    std::cout << "@average iterations per pixel:\t[" << sum / BUF_N << "]\n";
+    std::cout << "@stats only best:\t\t\t[" << min_stats << "] million cycles\n";
+    std::cout << "@stats + buffers best:\t\t[" << min_stored << "] million cycles\n";
+    std::cout << "@ISPC tasks + pass best:\t[" << min_pass << "] million cycles, "
+              << (pass_roots == root_pixels && pass_iters == iter_pixels ? "same" : "different") << " statistics\n";
+}
+
+/**
+ * Raises the iteration limit to refine_iters (--refine): continue from the kept state vs render again from scratch,
+ * with iters and found_roots as the working buffers.
+ */
+void benchRefine(const BenchSetup &s, const int refine_iters, std::unique_ptr<int[]> &iters,
+                 std::unique_ptr<int[]> &found_roots) {
+    const int n = s.n;
+    const int max_iters = s.max_iters;
+    std::unique_ptr<float[]> z_re(new float[BUF_N]);
+    std::unique_ptr<float[]> z_im(new float[BUF_N]);
+    std::vector<uint8_t> refine_palette(3 * (n + 1) * refine_iters);
+    palette_ispc(n, refine_iters, refine_palette.data());
+    const auto refine = [&](const char *name, const std::string &fn, const auto &run_continue) {
+        clearBuff(iters, found_roots);
+        std::fill_n(found_roots.get(), BUF_N, n);
+        run_continue(0, max_iters);
+        reset_and_start_timer();
+        run_continue(max_iters, refine_iters);
+        const double dt_continue = get_elapsed_mcycles();
+
+        std::fill_n(found_roots.get(), BUF_N, n);
+        reset_and_start_timer();
+        run_continue(0, refine_iters);
+        const double dt_scratch = get_elapsed_mcycles();
+
+        colourize_ispc_tasks(iters.get(), found_roots.get(), refine_palette.data(), refine_iters, BUF_N,
+                             s.image.get());
+        writePPM(s.image, fn);
+        std::cout << "@refine " << name << ":\t\t[" << dt_continue << ", " << dt_scratch
+                  << "] million cycles (continued, from scratch)\n";
+    };
+    refine("ISPC tasks", "../images/newton_refined.ppm", [&](const int start_iter, const int end_iter) {
+        newton_ispc_continue_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, start_iter, end_iter, iters.get(),
+                                   found_roots.get(), z_re.get(), z_im.get(), s.real.get(), s.imag.get(), n, &s.index,
+                                   s.poly, s.check_every, s.method);
+    });
+    refine("serial", "../images/newton_refined_serial.ppm", [&](const int start_iter, const int end_iter) {
+        newton_continue_cxx(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, start_iter, end_iter, iters, found_roots, z_re,
+                            z_im, s.real, s.imag, n, s.index, s.poly, s.method);
+    });
+}
+
 int main(const int argc, const char **argv) {
     // ---------
     // Read args
     // ---------
-    int n = -1;
-    if (argc < 2) {
-        n = 3;
-    } else if (argc == 2) {
-        if (strncmp(argv[1], "--n=", 4) == 0) {
-            n = static_cast<int>(strtol(argv[1] + 4, nullptr, 10));
+    int n = 3;
+    int max_iters = MAX_ITERS;
+    int refine_iters = 0;
+    int subdivide_band = -1;
+    bool symmetric = false;
+    int supersample = 0;
+    double progressive_budget = 0.0;
+    int zoom_frames = 0;
+    int query_points = 0;
+    bool stats = false;
+    bool pan = false;
+    int pan_x = 0, pan_y = 0;
+    bool grid_lookup = false;
+    bool compact = false;
+    bool trap = false;
+    int check_every = 1;
+    IterationMethod method = METHOD_NEWTON;
+    bool tiled = false;
+    GangFootprint footprint = FOOTPRINT_STRIP;
+    bool bench_footprints = false;
+    int tile_w = 0; // full rows
+    int tile_h = 4;
+    bool sweep_tiles = false;
+    OutputFormat output = OutputFormat::Wide;
+    std::vector<float> coef_re;
+    bool deep = false;
+    DoubleDouble view_x, view_y;
+    double view_r = 0.0;
+    Precision precision = PRECISION_AUTO;
+    for (int a = 1; a < argc; ++a) {
+        if (strncmp(argv[a], "--n=", 4) == 0) {
+            n = static_cast<int>(strtol(argv[a] + 4, nullptr, 10));
+        } else if (strncmp(argv[a], "--max-iters=", 12) == 0) {
+            max_iters = static_cast<int>(strtol(argv[a] + 12, nullptr, 10));
+        } else if (strncmp(argv[a], "--refine=", 9) == 0) {
+            refine_iters = static_cast<int>(strtol(argv[a] + 9, nullptr, 10));
+        } else if (strcmp(argv[a], "--symmetry") == 0) {
+            symmetric = true;
+        } else if (strncmp(argv[a], "--supersample=", 14) == 0) {
+            supersample = static_cast<int>(strtol(argv[a] + 14, nullptr, 10));
+            if (supersample < 2) {
+                usage(argv[0]);
+            }
+        } else if (strncmp(argv[a], "--progressive=", 14) == 0) {
+            progressive_budget = strtod(argv[a] + 14, nullptr);
+            if (progressive_budget <= 0.0) {
+                usage(argv[0]);
+            }
+        } else if (strncmp(argv[a], "--pan=", 6) == 0) {
+            pan = sscanf(argv[a] + 6, "%d,%d", &pan_x, &pan_y) == 2;
+            if (!pan) {
+                usage(argv[0]);
+            }
+        } else if (strncmp(argv[a], "--zoom=", 7) == 0) {
+            zoom_frames = static_cast<int>(strtol(argv[a] + 7, nullptr, 10));
+            if (zoom_frames < 1) {
+                usage(argv[0]);
+            }
+        } else if (strncmp(argv[a], "--query=", 8) == 0) {
+            query_points = static_cast<int>(strtol(argv[a] + 8, nullptr, 10));
+            if (query_points < 1) {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[a], "--stats") == 0) {
+            stats = true;
+        } else if (strncmp(argv[a], "--subdivide=", 12) == 0) {
+            subdivide_band = static_cast<int>(strtol(argv[a] + 12, nullptr, 10));
+            if (subdivide_band < 0) {
+                usage(argv[0]);
+            }
+        } else if (strncmp(argv[a], "--poly=", 7) == 0) {
+            coef_re = parseCoefficients(argv[a] + 7);
+            if (coef_re.size() < 2) {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[a], "--lookup=unity") == 0) {
+            grid_lookup = false;
+        } else if (strcmp(argv[a], "--lookup=grid") == 0) {
+            grid_lookup = true;
+        } else if (strcmp(argv[a], "--compact") == 0) {
+            compact = true;
+        } else if (strcmp(argv[a], "--trap") == 0) {
+            trap = true;
+        } else if (strncmp(argv[a], "--check-every=", 14) == 0) {
+            check_every = static_cast<int>(strtol(argv[a] + 14, nullptr, 10));
+            if (check_every < 1) {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[a], "--method=newton") == 0) {
+            method = METHOD_NEWTON;
+        } else if (strcmp(argv[a], "--method=halley") == 0) {
+            method = METHOD_HALLEY;
+        } else if (strcmp(argv[a], "--method=schroder") == 0) {
+            method = METHOD_SCHRODER;
+        } else if (strcmp(argv[a], "--layout=rows") == 0) {
+            tiled = false;
+        } else if (strcmp(argv[a], "--layout=tiled") == 0) {
+            tiled = true;
+        } else if (strcmp(argv[a], "--footprint=strip") == 0) {
+            footprint = FOOTPRINT_STRIP;
+        } else if (strcmp(argv[a], "--footprint=tiled") == 0) {
+            footprint = FOOTPRINT_TILED;
+        } else if (strcmp(argv[a], "--footprint=block") == 0) {
+            footprint = FOOTPRINT_BLOCK;
+        } else if (strcmp(argv[a], "--bench-footprints") == 0) {
+            bench_footprints = true;
+        } else if (strncmp(argv[a], "--task-tile=", 12) == 0) {
+            if (sscanf(argv[a] + 12, "%dx%d", &tile_w, &tile_h) != 2 || tile_w < 0 || tile_h < 1) {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[a], "--sweep-tiles") == 0) {
+            sweep_tiles = true;
+        } else if (strcmp(argv[a], "--output=wide") == 0) {
+            output = OutputFormat::Wide;
+        } else if (strcmp(argv[a], "--output=packed") == 0) {
+            output = OutputFormat::Packed;
+        } else if (strcmp(argv[a], "--output=rgb") == 0) {
+            output = OutputFormat::Rgb;
+        } else if (strncmp(argv[a], "--view=", 7) == 0) {
+            deep = parseView(argv[a] + 7, view_x, view_y, view_r);
+            if (!deep) {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[a], "--precision=auto") == 0) {
+            precision = PRECISION_AUTO;
+        } else if (strcmp(argv[a], "--precision=float") == 0) {
+            precision = PRECISION_FLOAT;
+        } else if (strcmp(argv[a], "--precision=double") == 0) {
+            precision = PRECISION_DOUBLE;
+        } else if (strcmp(argv[a], "--precision=dd") == 0) {
+            precision = PRECISION_DD;
         } else {
             usage(argv[0]);
         }
-    } else {
-        usage(argv[0]);
+    }
+
+    // z^n - 1 unless --poly was given; poly.degree == 0 selects the z^n - 1 kernels
+    std::vector<float> coef_im(coef_re.size(), 0.0f);
+    Polynomial poly{coef_re.data(), coef_im.data(), static_cast<int>(coef_re.size()) - 1};
+    poly.degree = std::max(poly.degree, 0);
+    if (poly.degree > 0) {
+        n = poly.degree;
     }
 
     const std::unique_ptr<float[]> real(new float[n]);
     const std::unique_ptr<float[]> imag(new float[n]);
-    initRoots(real, imag, n);
+    if (poly.degree > 0) {
+        const int sweeps = poly_roots_ispc(&poly, real.get(), imag.get(), MAX_ROOT_SWEEPS);
+        std::cout << "Found " << n << " roots in " << sweeps << " Aberth sweeps\n";
+    } else {
+        initRoots(real, imag, n);
+    }
+    // --trap: stop one step early inside each root's guaranteed-convergence radius (Newton steps only)
+    if (trap && method != METHOD_NEWTON) {
+        usage(argv[0]);
+    }
+    // --view: the double-double engines run Newton steps only
+    if (deep && method != METHOD_NEWTON) {
+        usage(argv[0]);
+    }
+    // --refine: the resumable engines take the iteration limit from --max-iters up to refine_iters (not deep views)
+    if (refine_iters != 0 && (refine_iters <= max_iters || deep)) {
+        usage(argv[0]);
+    }
+    if (subdivide_band >= 0 && deep) {
+        usage(argv[0]);
+    }
+    // --symmetry: z^n - 1 on the default viewport only
+    if (symmetric && (poly.degree > 0 || deep)) {
+        usage(argv[0]);
+    }
+    // --supersample: works from the wide buffers of the default viewport
+    if (supersample > 0 && (output != OutputFormat::Wide || deep)) {
+        usage(argv[0]);
+    }
+    if (progressive_budget > 0.0 && deep) {
+        usage(argv[0]);
+    }
+    if ((zoom_frames > 0 || query_points > 0) && deep) {
+        usage(argv[0]);
+    }
+    // --stats: checked against a pass over the wide buffers of the default viewport
+    if (stats && (output != OutputFormat::Wide || deep)) {
+        usage(argv[0]);
+    }
+    // --bench-footprints: the gang footprints of the row-major, non-compacted renders
+    if (bench_footprints && (compact || tiled || deep)) {
+        usage(argv[0]);
+    }
+    // --sweep-tiles: the task tiles of newton_ispc_tasks / newton_poly_ispc_tasks
+    if (sweep_tiles && (output != OutputFormat::Wide || deep || compact || tiled)) {
+        usage(argv[0]);
+    }
+    // --pan: moves the wide buffers of the default viewport
+    if (pan && (output != OutputFormat::Wide || deep)) {
+        usage(argv[0]);
+    }
+    std::vector<float> trap_r2;
+    float capture = RootLookup::CAPTURE;
+    if (trap) {
+        trap_r2 = trapRadii2(real.get(), imag.get(), n, poly.degree > 0 ? &poly : nullptr);
+        capture = std::max(capture, std::sqrt(*std::max_element(trap_r2.begin(), trap_r2.end())));
+    }
+    RootLookup roots = grid_lookup || poly.degree > 0 ? RootLookup::grid(real.get(), imag.get(), n, capture)
+                                                      : RootLookup::unity(capture);
+    if (trap) {
+        roots.setTrap(trap_r2);
+    }
     std::unique_ptr<int[]> iters;
     std::unique_ptr<int[]> found_roots;
+    // --output=packed: one 16-bit word per pixel, root ids and iteration counts have to fit a byte each, otherwise
+    // the wide pair is kept; --output=rgb: the engines colour the pixels and write the image itself.
+    // Both are for the row-major engines only
+    if (output != OutputFormat::Wide && (deep || compact || tiled)) {
+        usage(argv[0]);
+    }
+    if (output == OutputFormat::Packed && (n > 255 || max_iters > 256)) {
+        std::cout << "Packed output needs n <= 255 and max-iters <= 256, using the wide format\n";
+        output = OutputFormat::Wide;
+    }
+    std::unique_ptr<uint16_t[]> packed;
+    std::unique_ptr<uint8_t[]> rgb;
+    const auto clear = [&] {
+        if (output == OutputFormat::Packed) {
+            packed.reset(new uint16_t[BUF_N]);
+        } else if (output == OutputFormat::Rgb) {
+            rgb.reset(new uint8_t[3 * BUF_N]);
+        } else {
+            clearBuff(iters, found_roots);
+        }
+    };
+
+    // One colour per (root, iteration), built once; colourizing is then a parallel palette gather, and the serial
+    // --output=rgb engine colours from the same table
+    std::vector<uint8_t> palette(3 * (n + 1) * max_iters);
+    palette_ispc(n, max_iters, palette.data());
+
+    // Deep-zoom views go through the tiled mixed-precision kernels
+    const DoubleDouble deep_x_min = view_x - view_r;
+    const DoubleDouble deep_y_min = view_y - view_r;
+    const double deep_dx = 2.0 * view_r / WIDTH;
+    const double deep_dy = 2.0 * view_r / HEIGHT;
+    Polynomial *poly_ptr = poly.degree > 0 ? &poly : nullptr;
+    // --layout=tiled: the ISPC engines render tile-major and a parallel pass restores row-major order
+    std::vector<int> tiled_iters(tiled ? BUF_N : 0);
+    std::vector<int> tiled_found_roots(tiled ? BUF_N : 0);
+    const auto detile = [&] {
+        detile_ispc_tasks(tiled_iters.data(), iters.get(), WIDTH, HEIGHT, OUTPUT_TILE);
+        detile_ispc_tasks(tiled_found_roots.data(), found_roots.get(), WIDTH, HEIGHT, OUTPUT_TILE);
+    };
+    std::vector<int> tile_precision(((WIDTH + DEEP_TILE - 1) / DEEP_TILE) * ((HEIGHT + DEEP_TILE - 1) / DEEP_TILE));
+
+    const auto run_ispc = [&] {
+        if (deep) {
+            newton_ispc_deep(deep_x_min.hi, deep_x_min.lo, deep_y_min.hi, deep_y_min.lo, deep_dx, deep_dy, WIDTH,
+                             HEIGHT, max_iters, iters.get(), found_roots.get(), real.get(), imag.get(), n,
+                             &roots.index(), poly_ptr, precision, DEEP_TILE, nullptr);
+        } else if (compact) {
+            newton_ispc_compact(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters.get(), found_roots.get(),
+                                real.get(), imag.get(), n, &roots.index(), poly_ptr, method);
+        } else if (tiled) {
+            newton_ispc_tiled(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, tiled_iters.data(),
+                              tiled_found_roots.data(), real.get(), imag.get(), n, &roots.index(), poly_ptr, check_every,
+                              method, OUTPUT_TILE);
+            detile();
+        } else if (output == OutputFormat::Packed) {
+            newton_ispc_packed(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, packed.get(), real.get(),
+                               imag.get(), n, &roots.index(), poly_ptr, check_every, method, footprint);
+        } else if (output == OutputFormat::Rgb) {
+            newton_ispc_rgb(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, rgb.get(), real.get(), imag.get(), n,
+                            &roots.index(), poly_ptr, check_every, method, footprint);
+        } else if (poly.degree > 0) {
+            newton_poly_ispc(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters.get(), found_roots.get(),
+                             real.get(), imag.get(), &roots.index(), &poly, check_every, method, footprint);
+        } else {
+            newton_ispc(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters.get(), found_roots.get(),
+                        real.get(), imag.get(), n, &roots.index(), check_every, method, footprint);
+        }
+    };
+    const auto run_serial = [&] {
+        if (deep) {
+            newton_deep_cxx(deep_x_min, deep_y_min, deep_dx, deep_dy, WIDTH, HEIGHT, max_iters, iters, found_roots,
+                            real, imag, n, roots.index(), poly_ptr, precision, DEEP_TILE, nullptr);
+        } else if (output == OutputFormat::Packed) {
+            newton_packed_cxx(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, packed, real, imag, n,
+                              roots.index(), poly_ptr, method);
+        } else if (output == OutputFormat::Rgb) {
+            newton_rgb_cxx(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, rgb, palette.data(), real, imag, n,
+                           roots.index(), poly_ptr, method);
+        } else if (poly.degree > 0) {
+            newton_poly_cxx(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters, found_roots, real, imag,
+                            roots.index(), poly, method);
+        } else {
+            newton_cxx(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters, found_roots, real, imag, n,
+                       roots.index(), method);
+        }
+    };
+    const auto run_tasks = [&] {
+        if (deep) {
+            newton_ispc_deep_tasks(deep_x_min.hi, deep_x_min.lo, deep_y_min.hi, deep_y_min.lo, deep_dx, deep_dy,
+                                   WIDTH, HEIGHT, max_iters, iters.get(), found_roots.get(), real.get(), imag.get(),
+                                   n, &roots.index(), poly_ptr, precision, DEEP_TILE, tile_precision.data());
+        } else if (compact) {
+            newton_ispc_compact_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters.get(),
+                                      found_roots.get(), real.get(), imag.get(), n, &roots.index(), poly_ptr,
+                                      method);
+        } else if (tiled) {
+            newton_ispc_tiled_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, tiled_iters.data(),
+                                    tiled_found_roots.data(), real.get(), imag.get(), n, &roots.index(), poly_ptr,
+                                    check_every, method, OUTPUT_TILE);
+            detile();
+        } else if (output == OutputFormat::Packed) {
+            newton_ispc_packed_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, packed.get(), real.get(),
+                                     imag.get(), n, &roots.index(), poly_ptr, check_every, method, footprint);
+        } else if (output == OutputFormat::Rgb) {
+            newton_ispc_rgb_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, rgb.get(), real.get(),
+                                  imag.get(), n, &roots.index(), poly_ptr, check_every, method, footprint);
+        } else if (poly.degree > 0) {
+            newton_poly_ispc_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters.get(),
+                                   found_roots.get(), real.get(), imag.get(), &roots.index(), &poly, check_every, method,
+                                   footprint, tile_w, tile_h);
+        } else {
+            newton_ispc_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, max_iters, iters.get(), found_roots.get(),
+                              real.get(), imag.get(), n, &roots.index(), check_every, method, footprint, tile_w, tile_h);
+        }
+    };
+
+    std::cout << "@ISPC target:\t\t\t\t[" << isaName(newton_ispc_target_isa()) << " x" << newton_ispc_gang_width()
+              << "]\n";
+
+    // Task tiles of newton_ispc_tasks for this image and core count; the best one is kept for the runs below
+    if (sweep_tiles) {
+        const int widths[] = {0, 256, 128, 64, 32, 16};
+        const int heights[] = {1, 2, 4, 8, 16, 32};
+        double best = 1e30;
+        int best_w = tile_w, best_h = tile_h;
+        std::cout << "@task tiles:\t\t\t\t[" << std::thread::hardware_concurrency() << " hardware threads]\n";
+        for (const int w : widths) {
+            for (const int h : heights) {
+                tile_w = w;
+                tile_h = h;
+                double dt = 1e30;
+                for (int i = 0; i < TEST_ITERS; ++i) {
+                    clear();
+                    reset_and_start_timer();
+                    run_tasks();
+                    dt = std::min(dt, get_elapsed_mcycles());
+                }
+                std::cout << "\t\t\t\t\t" << (w > 0 ? std::to_string(w) : "full") << "x" << h << ": " << dt
+                          << " million cycles\n";
+                if (dt < best) {
+                    best = dt;
+                    best_w = w;
+                    best_h = h;
+                }
+            }
+        }
+        tile_w = best_w;
+        tile_h = best_h;
+        std::cout << "@best task tile:\t\t\t[" << (tile_w > 0 ? std::to_string(tile_w) : "full") << "x" << tile_h
+                  << "] " << best << " million cycles\n";
+    }
+
+    // Gang footprints of newton_ispc / newton_ispc_tasks side by side
+    if (bench_footprints) {
+        const GangFootprint selected = footprint;
+        const std::pair<GangFootprint, const char *> footprints[] = {
+            {FOOTPRINT_STRIP, "strip"}, {FOOTPRINT_TILED, "tiled"}, {FOOTPRINT_BLOCK, "block"}};
+        for (const auto &[fp, name] : footprints) {
+            footprint = fp;
+            double best = 1e30, best_tasks = 1e30;
+            for (int i = 0; i < TEST_ITERS; ++i) {
+                clear();
+                reset_and_start_timer();
+                run_ispc();
+                best = std::min(best, get_elapsed_mcycles());
+                reset_and_start_timer();
+                run_tasks();
+                best_tasks = std::min(best_tasks, get_elapsed_mcycles());
+            }
+            std::cout << "@footprint " << name << ":\t\t\t[" << best << ", " << best_tasks
+                      << "] million cycles (ISPC, ISPC tasks)\n";
+        }
+        footprint = selected;
+    }
+
+    // The image coloured by the kernels is written as it is and keeps no iteration counts to average
+    const std::unique_ptr<uint8_t[]> image(new uint8_t[3 * BUF_N]);
+    const auto report = [&](const std::string &fn) {
+        if (output == OutputFormat::Rgb) {
+            writePPM(rgb, fn);
+            return;
+        }
+        reset_and_start_timer();
+        if (output == OutputFormat::Packed) {
+            colourize_packed_ispc_tasks(packed.get(), palette.data(), max_iters, BUF_N, image.get());
+        } else {
+            colourize_ispc_tasks(iters.get(), found_roots.get(), palette.data(), max_iters, BUF_N, image.get());
+        }
+        const double dt = get_elapsed_mcycles();
+        writePPM(image, fn);
+        std::cout << "@colourize:\t\t\t\t[" << dt << "] million cycles\n";
+
+        const double average = output == OutputFormat::Packed ? averageIterations(packed, n, max_iters)
+                                                              : averageIterations(iters, found_roots, n, max_iters);
+        std::cout << "@average iterations per pixel:\t[" << average << "]\n";
+    };
 
     double min_ISPC = 1e30;
     for (int i = 0; i < TEST_ITERS; ++i) {
-        clearBuff(iters, found_roots);
+        clear();
         reset_and_start_timer();
-        newton_ispc(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, MAX_ITERS, iters.get(), found_roots.get(), real.get(),
-                    imag.get(), n);
+        run_ispc();
         const double dt = get_elapsed_mcycles();
         std::cout << "@time of ISPC run:\t\t\t[" << dt << "] million cycles\n";
         min_ISPC = std::min(min_ISPC, dt);
     }
 
     std::cout << "@newton ispc best:\t\t\t[" << min_ISPC << "] million cycles\n";
-    writePPM(iters, found_roots, n, "../images/newton.ppm");
+    report("../images/newton.ppm");
 
     double min_serial = 1e30;
     for (int i = 0; i < TEST_ITERS; ++i) {
-        clearBuff(iters, found_roots);
+        clear();
         reset_and_start_timer();
-        newton_cxx(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, MAX_ITERS, iters, found_roots, real, imag, n);
+        run_serial();
         const double dt = get_elapsed_mcycles();
         std::cout << "@time of serial run:\t\t[" << dt << "] million cycles\n";
         min_serial = std::min(min_serial, dt);
     }
 
     std::cout << "@newton serial best:\t\t[" << min_serial << "] million cycles\n";
-    writePPM(iters, found_roots, n, "../images/newton_serial.ppm");
+    report("../images/newton_serial.ppm");
 
     double min_ISPC_tasks = 1e30;
     for (int i = 0; i < TEST_ITERS; ++i) {
-        clearBuff(iters, found_roots);
+        clear();
         reset_and_start_timer();
-        newton_ispc_tasks(X_MIN, Y_MIN, X_MAX, Y_MAX, WIDTH, HEIGHT, MAX_ITERS, iters.get(), found_roots.get(),
-                          real.get(), imag.get(), n);
+        run_tasks();
         const double dt = get_elapsed_mcycles();
         std::cout << "@time of ISPC tasks run:\t[" << dt << "] million cycles\n";
         min_ISPC_tasks = std::min(min_ISPC_tasks, dt);
     }
 
     std::cout << "@newton ISPC tasks best:\t[" << min_ISPC_tasks << "] million cycles\n";
-    writePPM(iters, found_roots, n, "../images/newton_tasks.ppm");
+    report("../images/newton_tasks.ppm");
+
+    if (deep) {
+        int per_precision[4] = {0, 0, 0, 0};
+        for (const int p : tile_precision) {
+            ++per_precision[p];
+        }
+        std::cout << "@deep tiles:\t\t\t\t[" << per_precision[PRECISION_FLOAT] << " float, "
+                  << per_precision[PRECISION_DOUBLE] << " double, " << per_precision[PRECISION_DD]
+                  << " double-double]\n";
+    }
+
+    // The modes below compare against the wide buffers of the ISPC tasks run, when there are any
+    const bool wide = output == OutputFormat::Wide;
+    const BenchSetup setup{.n = n,
+                           .max_iters = max_iters,
+                           .real = real,
+                           .imag = imag,
+                           .index = roots.index(),
+                           .poly = poly_ptr,
+                           .check_every = check_every,
+                           .method = method,
+                           .footprint = footprint,
+                           .tile_w = tile_w,
+                           .tile_h = tile_h,
+                           .palette = palette.data(),
+                           .iters = wide ? iters.get() : nullptr,
+                           .found_roots = wide ? found_roots.get() : nullptr,
+                           .image = image};
+    if (trap && !deep) {
+        benchTrapSteps(setup);
+    }
+    if (subdivide_band >= 0) {
+        benchSubdivide(setup, subdivide_band);
+    }
+    if (symmetric) {
+        benchSymmetric(setup);
+    }
+    if (supersample > 0) {
+        benchSupersample(setup, supersample);
+    }
+    if (progressive_budget > 0.0) {
+        benchProgressive(setup, progressive_budget);
+    }
+    if (pan) {
+        benchPan(setup, pan_x, pan_y);
+    }
+    if (zoom_frames > 0) {
+        benchZoom(setup, zoom_frames);
+    }
+    if (query_points > 0) {
+        benchQuery(setup, query_points);
+    }
+    if (stats) {
+        benchStats(setup, run_tasks);
+    }
+    if (refine_iters > 0) {
+        benchRefine(setup, refine_iters, iters, found_roots);
+    }
 
     std::cout << "\n\t\t\t\t(" << min_serial / min_ISPC << "x speedup from ISPC)\n";
     std::cout << "\n\t\t\t\t(" << min_serial / min_ISPC_tasks << "x speedup from ISPC tasks)\n";